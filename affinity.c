@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include "affinity.h"
+
+affinity_policy_t affinity_policy = AFFINITY_NONE;
+
+static const char *affinity_policy_names[NUM_AFFINITY_POLICIES] = {"none", "compact", "scatter"};
+
+struct cpu_info_s
+{
+    int cpu;
+    int package;   // physical_package_id
+    int core;      // core_id, unique within a package
+    int core_rank; // position of the core within its package
+    int smt;       // position of the CPU among its core's siblings
+};
+
+static int *cpu_order = NULL; // CPUs in the policy's order
+static int num_cpus = 0;
+static cpu_set_t process_cpus; // the process mask before anything was pinned
+
+const char *affinity_policy_name(affinity_policy_t policy)
+{
+    return affinity_policy_names[policy];
+}
+
+int affinity_policy_from_name(const char *name, affinity_policy_t *policy)
+{
+    for (int p = 0; p < NUM_AFFINITY_POLICIES; p++)
+    {
+        if (strcmp(name, affinity_policy_names[p]) == 0)
+        {
+            *policy = (affinity_policy_t)p;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Read one integer from /sys/devices/system/cpu/cpu<cpu>/topology/<name>
+static int read_topology(int cpu, const char *name, int fallback)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return fallback;
+    int value;
+    if (fscanf(fp, "%d", &value) != 1)
+        value = fallback;
+    fclose(fp);
+    return value;
+}
+
+static int compare_compact(const void *a, const void *b)
+{
+    const struct cpu_info_s *x = a, *y = b;
+    if (x->package != y->package)
+        return x->package - y->package;
+    if (x->core_rank != y->core_rank)
+        return x->core_rank - y->core_rank;
+    return x->smt - y->smt;
+}
+
+static int compare_scatter(const void *a, const void *b)
+{
+    const struct cpu_info_s *x = a, *y = b;
+    if (x->smt != y->smt)
+        return x->smt - y->smt;
+    if (x->core_rank != y->core_rank)
+        return x->core_rank - y->core_rank;
+    return x->package - y->package;
+}
+
+void affinity_init(void)
+{
+    // Only CPUs this process may run on, in ascending order
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    process_cpus = allowed;
+    struct cpu_info_s *cpus = malloc(CPU_SETSIZE * sizeof(struct cpu_info_s));
+    num_cpus = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        struct cpu_info_s *info = &cpus[num_cpus++];
+        info->cpu = cpu;
+        info->package = read_topology(cpu, "physical_package_id", 0);
+        info->core = read_topology(cpu, "core_id", cpu); // no topology: every CPU its own core
+    }
+
+    // Rank cores within their package and CPUs within their core, in CPU order
+    int packages = 0, cores = 0;
+    for (int i = 0; i < num_cpus; i++)
+    {
+        struct cpu_info_s *info = &cpus[i];
+        int new_package = 1, new_core = 1;
+        info->core_rank = 0;
+        info->smt = 0;
+        for (int j = 0; j < i; j++)
+        {
+            if (cpus[j].package != info->package)
+                continue;
+            new_package = 0;
+            if (cpus[j].core == info->core)
+            {
+                new_core = 0;
+                info->core_rank = cpus[j].core_rank;
+                info->smt++;
+            }
+        }
+        if (new_core)
+        {
+            // One more than the highest rank so far in this package
+            for (int j = 0; j < i; j++)
+            {
+                if (cpus[j].package == info->package && cpus[j].core_rank >= info->core_rank)
+                    info->core_rank = cpus[j].core_rank + 1;
+            }
+            cores++;
+        }
+        packages += new_package;
+    }
+
+    if (affinity_policy == AFFINITY_COMPACT)
+        qsort(cpus, num_cpus, sizeof(struct cpu_info_s), compare_compact);
+    else if (affinity_policy == AFFINITY_SCATTER)
+        qsort(cpus, num_cpus, sizeof(struct cpu_info_s), compare_scatter);
+
+    free(cpu_order);
+    cpu_order = malloc(num_cpus * sizeof(int));
+    for (int i = 0; i < num_cpus; i++)
+        cpu_order[i] = cpus[i].cpu;
+    free(cpus);
+
+    printf("Topology: %d package(s), %d core(s), %d CPU(s); affinity = %s\n",
+           packages, cores, num_cpus, affinity_policy_name(affinity_policy));
+}
+
+void affinity_pin_thread(int index)
+{
+    if (affinity_policy == AFFINITY_NONE || num_cpus == 0)
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_order[index % num_cpus], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        fprintf(stderr, "Could not pin thread %d to CPU %d\n", index, cpu_order[index % num_cpus]);
+}
+
+void affinity_unpin_thread(void)
+{
+    if (affinity_policy == AFFINITY_NONE || num_cpus == 0)
+        return;
+    if (pthread_setaffinity_np(pthread_self(), sizeof(process_cpus), &process_cpus) != 0)
+        fprintf(stderr, "Could not unpin helper thread\n");
+}
+
+void affinity_describe(int thread_count, char *buf, size_t len)
+{
+    snprintf(buf, len, "%s", affinity_policy_name(affinity_policy));
+    if (affinity_policy == AFFINITY_NONE || num_cpus == 0)
+        return;
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        char cpu[16];
+        snprintf(cpu, sizeof(cpu), " %d", cpu_order[i % num_cpus]);
+
+        // Keep room for the " ..." that marks a cut-off mapping
+        size_t used = strlen(buf);
+        size_t reserve = i + 1 < thread_count ? strlen(" ...") : 0;
+        if (used + strlen(cpu) + reserve >= len)
+        {
+            if (used + strlen(" ...") < len)
+                strcpy(buf + used, " ...");
+            return;
+        }
+        strcpy(buf + used, cpu);
+    }
+}
+
+size_t affinity_describe_size(int thread_count)
+{
+    // Policy name, then " <cpu>" per worker with at most 11 digits and sign
+    return 32 + (size_t)thread_count * 12;
+}
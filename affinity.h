@@ -0,0 +1,44 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stddef.h>
+
+// Placement of the worker threads (--affinity=POLICY). The topology comes
+// from /sys/devices/system/cpu/cpuN/topology; worker i of a run is pinned
+// to the i-th CPU of the policy's order (wrapping around when threads
+// outnumber CPUs).
+
+typedef enum
+{
+    AFFINITY_NONE,    // leave placement to the scheduler
+    AFFINITY_COMPACT, // fill the SMT siblings of a core, then the next core, then the next socket
+    AFFINITY_SCATTER, // one thread per socket in turn, a new physical core before any SMT sibling
+    NUM_AFFINITY_POLICIES
+} affinity_policy_t;
+
+// Policy used for the worker threads; set by main.c
+extern affinity_policy_t affinity_policy;
+
+const char *affinity_policy_name(affinity_policy_t policy);
+int affinity_policy_from_name(const char *name, affinity_policy_t *policy);
+
+// Read the topology and build the CPU order of affinity_policy; prints
+// the topology. Call once before any worker starts.
+void affinity_init(void);
+
+// Pin the calling thread to the CPU of worker index; no-op for AFFINITY_NONE
+void affinity_pin_thread(int index);
+
+// Let the calling thread run on every CPU the process had at affinity_init,
+// for helper threads started from a pinned thread; no-op for AFFINITY_NONE
+void affinity_unpin_thread(void);
+
+// Mapping of a run with thread_count workers for output and CSV rows,
+// e.g. "compact 0 2 1 3" (CPU of worker 0, 1, ...) or "none"; a mapping
+// that does not fit in len ends in " ..."
+void affinity_describe(int thread_count, char *buf, size_t len);
+
+// Buffer size that always holds the mapping of thread_count workers
+size_t affinity_describe_size(int thread_count);
+
+#endif
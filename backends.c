@@ -0,0 +1,32 @@
+#include <string.h>
+#include "run_threads.h"
+
+// Position in this table is the backend's program_type
+const struct list_backend_s list_backends[] = {
+    {"serial", "Serial", run_threads_serial},
+    {"mutex", "Mutex", run_threads_mutex},
+    {"rwlock", "RWLock", run_threads_rwlock},
+    {"hoh", "HandOverHand", run_threads_hoh},
+    {"lazy", "LazyList", run_threads_lazy},
+    {"lockfree", "LockFree", run_threads_lockfree},
+    {"skiplist", "SkipList", run_threads_skiplist},
+    {"unrolled", "Unrolled", run_threads_unrolled},
+    {"sharded", "Sharded", run_threads_sharded},
+    {"rcu", "RCU", run_threads_rcu},
+    {"drwlock", "DistRWLock", run_threads_drwlock},
+    {"fc", "FlatCombining", run_threads_fc},
+    {"blink", "BLinkTree", run_threads_blink},
+    {"hash", "HashSet", run_threads_hash},
+};
+
+const int num_list_backends = sizeof(list_backends) / sizeof(list_backends[0]);
+
+int find_backend(const char *name)
+{
+    for (int i = 0; i < num_list_backends; i++)
+    {
+        if (strcmp(list_backends[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bench_stats.h"
+
+// Two-sided 95% critical values of Student's t for 1..30 degrees of freedom
+static const double t_95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+static int compare_times(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+// q-th quantile of sorted[0..count) with linear interpolation
+static double quantile(const unsigned long *sorted, int count, double q)
+{
+    double pos = q * (count - 1);
+    int lower = (int)pos;
+    if (lower + 1 >= count)
+        return sorted[count - 1];
+    return sorted[lower] + (pos - lower) * ((double)sorted[lower + 1] - sorted[lower]);
+}
+
+void run_stats_compute(const unsigned long *times, int runs, struct run_stats_s *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->runs = runs;
+    if (runs == 0)
+        return;
+
+    unsigned long *sorted = malloc(runs * sizeof(unsigned long));
+    memcpy(sorted, times, runs * sizeof(unsigned long));
+    qsort(sorted, runs, sizeof(unsigned long), compare_times);
+
+    // Keep the sorted times inside Tukey's fences
+    int first = 0, last = runs; // kept range [first, last)
+    if (runs >= STATS_MIN_FOR_OUTLIERS)
+    {
+        double q1 = quantile(sorted, runs, 0.25), q3 = quantile(sorted, runs, 0.75);
+        double low = q1 - 1.5 * (q3 - q1), high = q3 + 1.5 * (q3 - q1);
+        while (first < last && sorted[first] < low)
+            first++;
+        while (last > first && sorted[last - 1] > high)
+            last--;
+    }
+    int kept = last - first;
+    stats->outliers = runs - kept;
+
+    double sum = 0;
+    for (int i = first; i < last; i++)
+        sum += sorted[i];
+    stats->mean = sum / kept;
+    stats->median = quantile(sorted + first, kept, 0.5);
+    stats->min = sorted[first];
+    stats->max = sorted[last - 1];
+
+    if (kept > 1)
+    {
+        double variance = 0;
+        for (int i = first; i < last; i++)
+            variance += (sorted[i] - stats->mean) * (sorted[i] - stats->mean);
+        stats->std_dev = sqrt(variance / (kept - 1));
+        double t = kept - 1 <= 30 ? t_95[kept - 2] : 1.96;
+        stats->ci_half = t * stats->std_dev / sqrt(kept);
+    }
+    free(sorted);
+}
@@ -0,0 +1,26 @@
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+// Summary statistics of the run times of one case. Outliers are rejected
+// with Tukey's fences: once there are at least STATS_MIN_FOR_OUTLIERS
+// runs, a time below Q1 - 1.5 IQR or above Q3 + 1.5 IQR (quartiles by
+// linear interpolation) is left out of every statistic except runs. The
+// 95% confidence interval uses the sample standard deviation and
+// Student's t for the number of kept runs.
+
+#define STATS_MIN_FOR_OUTLIERS 5
+
+struct run_stats_s
+{
+    int runs;      // samples taken
+    int outliers;  // rejected by the rule above
+    double mean;   // microseconds, over the kept runs
+    double std_dev;
+    double median;
+    double ci_half; // half-width of the 95% confidence interval of the mean
+    unsigned long min, max;
+};
+
+void run_stats_compute(const unsigned long *times, int runs, struct run_stats_s *stats);
+
+#endif
@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// B-link tree (Lehman and Yao) with optimistic lock coupling (Leis et al.).
+// Every node has a high key and a link to its right sibling, so a search
+// that lands on a node that was split under it simply moves right. Readers
+// take no locks: they read a node's version, read the node and check that
+// the version is unchanged. Writers lock one node at a time. Deleted keys
+// just leave their leaf; nodes are never merged or freed during a run.
+
+#define CACHE_LINE 64
+#define BLINK_KEYS 18 // 32-byte header + 18 keys + 19 children = 4 cache lines
+#define BLINK_FILL 14 // keys per node when building, leaves room for inserts
+#define SPINS_BEFORE_YIELD 64
+
+#define VERSION_LOCKED 1 // bit 0 of a node's version; every lock/unlock pair adds 2
+
+struct blink_node_s
+{
+    _Atomic uint64_t version;     // odd while a writer holds the node
+    atomic_int count;             // keys in use
+    int level;                    // 0 for leaves
+    atomic_int high_key;          // every key in the node is below it; INT_MAX on the right edge
+    _Atomic(struct blink_node_s *) right;
+    atomic_int keys[BLINK_KEYS]; // sorted; a leaf search reads only these first two lines
+    _Atomic(struct blink_node_s *) children[BLINK_KEYS + 1]; // children[i] holds keys below keys[i]
+} __attribute__((aligned(CACHE_LINE)));
+
+_Static_assert(sizeof(struct blink_node_s) == 4 * CACHE_LINE, "B-link node is not 4 cache lines");
+
+struct blink_tree_s
+{
+    _Atomic(struct blink_node_s *) root;
+    pthread_mutex_t root_mutex; // serializes growing the tree by a level
+};
+
+typedef struct
+{
+    struct blink_tree_s *tree;
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+} thread_params_t;
+
+// Node fields are atomics because readers race with writers; the version
+// check, not the memory order, is what makes a read consistent
+#define LOAD(field) atomic_load_explicit(&(field), memory_order_relaxed)
+#define STORE(field, value) atomic_store_explicit(&(field), (value), memory_order_relaxed)
+
+static struct blink_node_s *blink_new_node(int level)
+{
+    struct blink_node_s *node = aligned_alloc(CACHE_LINE, sizeof(struct blink_node_s));
+    atomic_init(&node->version, 0);
+    atomic_init(&node->count, 0);
+    node->level = level;
+    atomic_init(&node->high_key, INT_MAX);
+    atomic_init(&node->right, NULL);
+    for (int i = 0; i < BLINK_KEYS; i++)
+        atomic_init(&node->keys[i], INT_MAX);
+    for (int i = 0; i <= BLINK_KEYS; i++)
+        atomic_init(&node->children[i], NULL);
+    return node;
+}
+
+// Spin briefly, then give the CPU away (threads may outnumber cores)
+static inline void backoff(int *spins)
+{
+    if (++(*spins) >= SPINS_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Optimistic read: wait until no writer holds the node and return its version
+static uint64_t blink_read_begin(struct blink_node_s *node)
+{
+    int spins = 0;
+    uint64_t version;
+    while ((version = atomic_load_explicit(&node->version, memory_order_acquire)) & VERSION_LOCKED)
+        backoff(&spins);
+    return version;
+}
+
+// Whether everything read from the node since blink_read_begin is consistent
+static int blink_read_valid(struct blink_node_s *node, uint64_t version)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&node->version, memory_order_relaxed) == version;
+}
+
+static void blink_lock(struct blink_node_s *node)
+{
+    int spins = 0;
+    for (;;)
+    {
+        uint64_t version = atomic_load_explicit(&node->version, memory_order_relaxed);
+        if (!(version & VERSION_LOCKED) &&
+            atomic_compare_exchange_weak(&node->version, &version, version | VERSION_LOCKED))
+            break;
+        backoff(&spins);
+    }
+    // Readers must see the odd version before any of the writes that follow
+    atomic_thread_fence(memory_order_release);
+}
+
+static void blink_unlock(struct blink_node_s *node)
+{
+    uint64_t version = atomic_load_explicit(&node->version, memory_order_relaxed);
+    atomic_store_explicit(&node->version, version + 1, memory_order_release);
+}
+
+// First position whose key is not below value
+static int blink_lower_bound(struct blink_node_s *node, int count, int value)
+{
+    int pos = 0;
+    while (pos < count && LOAD(node->keys[pos]) < value)
+        pos++;
+    return pos;
+}
+
+// Child of an inner node that covers value
+static int blink_child_index(struct blink_node_s *node, int count, int value)
+{
+    int pos = 0;
+    while (pos < count && LOAD(node->keys[pos]) <= value)
+        pos++;
+    return pos;
+}
+
+// Key count read without a lock; clamped so a torn read stays in bounds
+static int blink_count(struct blink_node_s *node)
+{
+    int count = LOAD(node->count);
+    return count < 0 ? 0 : count > BLINK_KEYS ? BLINK_KEYS : count;
+}
+
+// Optimistic descent from node to the node at level that covers value,
+// moving right past splits. Returns it with the version it was read at.
+static struct blink_node_s *blink_walk(struct blink_node_s *node, int value, int level, uint64_t *version_p)
+{
+    uint64_t version = blink_read_begin(node);
+    for (;;)
+    {
+        struct blink_node_s *next;
+        if (value >= LOAD(node->high_key))
+            next = LOAD(node->right);
+        else if (node->level == level)
+        {
+            *version_p = version;
+            return node;
+        }
+        else
+            next = LOAD(node->children[blink_child_index(node, blink_count(node), value)]);
+
+        // Follow a pointer only if it was read from a consistent node
+        if (blink_read_valid(node, version) && next != NULL)
+            node = next;
+        version = blink_read_begin(node);
+    }
+}
+
+static struct blink_node_s *blink_find(struct blink_tree_s *tree, int value, int level, uint64_t *version_p)
+{
+    return blink_walk(atomic_load_explicit(&tree->root, memory_order_acquire), value, level, version_p);
+}
+
+// Lock the node that covers value, starting at node and moving right
+// with at most two locks held (Lehman and Yao)
+static struct blink_node_s *blink_lock_covering(struct blink_node_s *node, int value)
+{
+    blink_lock(node);
+    while (value >= LOAD(node->high_key))
+    {
+        struct blink_node_s *next = LOAD(node->right);
+        blink_lock(next);
+        blink_unlock(node);
+        node = next;
+    }
+    return node;
+}
+
+// Insert key at pos of a locked node; in an inner node child goes right of
+// it. A full node is split: its upper half moves to a new right sibling,
+// which is returned with the separator key in *sep_p, or NULL otherwise.
+static struct blink_node_s *blink_node_insert(struct blink_node_s *node, int pos, int key,
+                                              struct blink_node_s *child, int *sep_p)
+{
+    int keys[BLINK_KEYS + 1];
+    struct blink_node_s *children[BLINK_KEYS + 2];
+    int count = LOAD(node->count);
+    int leaf = node->level == 0;
+
+    for (int i = 0, j = 0; i <= count; i++)
+        keys[i] = i == pos ? key : LOAD(node->keys[j++]);
+    if (!leaf)
+    {
+        for (int i = 0, j = 0; i <= count + 1; i++)
+            children[i] = i == pos + 1 ? child : LOAD(node->children[j++]);
+    }
+    int total = count + 1;
+
+    // Fits: write the node back in place
+    if (total <= BLINK_KEYS)
+    {
+        for (int i = pos; i < total; i++)
+            STORE(node->keys[i], keys[i]);
+        for (int i = pos + 1; !leaf && i <= total; i++)
+            STORE(node->children[i], children[i]);
+        STORE(node->count, total);
+        return NULL;
+    }
+
+    // Split: a leaf copies its separator up, an inner node moves it up
+    int left = total / 2;
+    int first_right = leaf ? left : left + 1;
+    struct blink_node_s *sibling = blink_new_node(node->level);
+    for (int i = first_right; i < total; i++)
+        atomic_init(&sibling->keys[i - first_right], keys[i]);
+    for (int i = first_right; !leaf && i <= total; i++)
+        atomic_init(&sibling->children[i - first_right], children[i]);
+    atomic_init(&sibling->count, total - first_right);
+    atomic_init(&sibling->high_key, LOAD(node->high_key));
+    atomic_init(&sibling->right, LOAD(node->right));
+
+    // The sibling is complete before the node links to it
+    for (int i = 0; i < BLINK_KEYS; i++)
+        STORE(node->keys[i], i < left ? keys[i] : INT_MAX);
+    for (int i = 0; !leaf && i <= BLINK_KEYS; i++)
+        STORE(node->children[i], i <= left ? children[i] : NULL);
+    STORE(node->count, left);
+    STORE(node->high_key, keys[left]);
+    STORE(node->right, sibling);
+
+    *sep_p = keys[left];
+    return sibling;
+}
+
+// node (locked) was just split into node and sibling at sep: add sep to
+// the level above, splitting upwards as far as needed. Unlocks node.
+static void blink_insert_parent(struct blink_tree_s *tree, struct blink_node_s *node,
+                                int sep, struct blink_node_s *sibling)
+{
+    for (;;)
+    {
+        int level = node->level;
+
+        // The root's level is the top one; splitting the root adds a level
+        pthread_mutex_lock(&tree->root_mutex);
+        struct blink_node_s *root = LOAD(tree->root);
+        while (root != node && root->level == level)
+        {
+            // A left neighbour was the root and is still installing the new one
+            pthread_mutex_unlock(&tree->root_mutex);
+            sched_yield();
+            pthread_mutex_lock(&tree->root_mutex);
+            root = LOAD(tree->root);
+        }
+        if (root == node)
+        {
+            struct blink_node_s *new_root = blink_new_node(level + 1);
+            atomic_init(&new_root->keys[0], sep);
+            atomic_init(&new_root->children[0], node);
+            atomic_init(&new_root->children[1], sibling);
+            atomic_init(&new_root->count, 1);
+            atomic_store_explicit(&tree->root, new_root, memory_order_release);
+            pthread_mutex_unlock(&tree->root_mutex);
+            blink_unlock(node);
+            return;
+        }
+        pthread_mutex_unlock(&tree->root_mutex);
+        blink_unlock(node);
+
+        // Readers reach sibling through the right link until the parent
+        // has it; separators may arrive at the parent in any order
+        uint64_t version;
+        struct blink_node_s *parent = blink_find(tree, sep, level + 1, &version);
+        parent = blink_lock_covering(parent, sep);
+        int pos = blink_child_index(parent, LOAD(parent->count), sep);
+        int parent_sep;
+        struct blink_node_s *parent_sibling = blink_node_insert(parent, pos, sep, sibling, &parent_sep);
+        if (parent_sibling == NULL)
+        {
+            blink_unlock(parent);
+            return;
+        }
+        node = parent;
+        sep = parent_sep;
+        sibling = parent_sibling;
+    }
+}
+
+static int blink_member(struct blink_tree_s *tree, int value)
+{
+    uint64_t version;
+    struct blink_node_s *leaf = blink_find(tree, value, 0, &version);
+    for (;;)
+    {
+        int count = blink_count(leaf);
+        int pos = blink_lower_bound(leaf, count, value);
+        int found = pos < count && LOAD(leaf->keys[pos]) == value;
+        if (blink_read_valid(leaf, version))
+            return found;
+        // Changed under us; a split may have moved value to the right
+        leaf = blink_walk(leaf, value, 0, &version);
+    }
+}
+
+static int blink_insert(struct blink_tree_s *tree, int value)
+{
+    uint64_t version;
+    struct blink_node_s *leaf = blink_find(tree, value, 0, &version);
+    leaf = blink_lock_covering(leaf, value);
+
+    int count = LOAD(leaf->count);
+    int pos = blink_lower_bound(leaf, count, value);
+    if (pos < count && LOAD(leaf->keys[pos]) == value)
+    {
+        blink_unlock(leaf);
+        return 0;
+    }
+
+    int sep;
+    struct blink_node_s *sibling = blink_node_insert(leaf, pos, value, NULL, &sep);
+    if (sibling == NULL)
+        blink_unlock(leaf);
+    else
+        blink_insert_parent(tree, leaf, sep, sibling);
+    return 1;
+}
+
+static int blink_delete(struct blink_tree_s *tree, int value)
+{
+    uint64_t version;
+    struct blink_node_s *leaf = blink_find(tree, value, 0, &version);
+    leaf = blink_lock_covering(leaf, value);
+
+    int count = LOAD(leaf->count);
+    int pos = blink_lower_bound(leaf, count, value);
+    int found = pos < count && LOAD(leaf->keys[pos]) == value;
+    if (found)
+    {
+        for (int i = pos; i < count - 1; i++)
+            STORE(leaf->keys[i], LOAD(leaf->keys[i + 1]));
+        STORE(leaf->keys[count - 1], INT_MAX);
+        STORE(leaf->count, count - 1);
+    }
+    blink_unlock(leaf);
+    return found;
+}
+
+// Bulk-load the tree from the (already sorted) initial list: fill leaves
+// left to right, then build each level above from the one below
+static void blink_build(struct blink_tree_s *tree, struct list_node_s *head_p)
+{
+    // Nodes of the level being built and the lowest key each one covers
+    int capacity = 16, num = 0;
+    struct blink_node_s **nodes = malloc(capacity * sizeof(struct blink_node_s *));
+    int *low_keys = malloc(capacity * sizeof(int));
+
+    struct blink_node_s *leaf = blink_new_node(0);
+    nodes[num] = leaf;
+    low_keys[num++] = INT_MIN;
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        int count = LOAD(leaf->count);
+        if (count == BLINK_FILL)
+        {
+            struct blink_node_s *next = blink_new_node(0);
+            STORE(leaf->high_key, curr_p->data);
+            STORE(leaf->right, next);
+            leaf = next;
+            count = 0;
+            if (num == capacity)
+            {
+                capacity *= 2;
+                nodes = realloc(nodes, capacity * sizeof(struct blink_node_s *));
+                low_keys = realloc(low_keys, capacity * sizeof(int));
+            }
+            nodes[num] = leaf;
+            low_keys[num++] = curr_p->data;
+        }
+        STORE(leaf->keys[count], curr_p->data);
+        STORE(leaf->count, count + 1);
+    }
+
+    // Each parent takes BLINK_FILL + 1 children; the separators are their low keys
+    for (int level = 1; num > 1; level++)
+    {
+        int parents = 0;
+        struct blink_node_s *parent = NULL;
+        for (int i = 0; i < num; i++)
+        {
+            if (parent == NULL || LOAD(parent->count) == BLINK_FILL)
+            {
+                struct blink_node_s *next = blink_new_node(level);
+                if (parent != NULL)
+                {
+                    STORE(parent->high_key, low_keys[i]);
+                    STORE(parent->right, next);
+                }
+                parent = next;
+                STORE(parent->children[0], nodes[i]);
+                // The arrays are reused: parents never catch up with the child being read
+                nodes[parents] = parent;
+                low_keys[parents++] = low_keys[i];
+                continue;
+            }
+            int count = LOAD(parent->count);
+            STORE(parent->keys[count], low_keys[i]);
+            STORE(parent->children[count + 1], nodes[i]);
+            STORE(parent->count, count + 1);
+        }
+        num = parents;
+    }
+
+    atomic_init(&tree->root, nodes[0]);
+    pthread_mutex_init(&tree->root_mutex, NULL);
+    free(nodes);
+    free(low_keys);
+}
+
+// Free every node, one level at a time from the left edge
+static void blink_destroy(struct blink_tree_s *tree)
+{
+    struct blink_node_s *first = LOAD(tree->root);
+    while (first != NULL)
+    {
+        struct blink_node_s *below = first->level > 0 ? LOAD(first->children[0]) : NULL;
+        struct blink_node_s *curr_p = first;
+        while (curr_p != NULL)
+        {
+            struct blink_node_s *next = LOAD(curr_p->right);
+            free(curr_p);
+            curr_p = next;
+        }
+        first = below;
+    }
+    pthread_mutex_destroy(&tree->root_mutex);
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, readers never lock
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            blink_insert(params->tree, val);
+        else if (op == 1)
+            blink_delete(params->tree, val);
+        else
+            blink_member(params->tree, val);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_blink(struct list_node_s **list_head,
+                         int m,
+                         double mMember,
+                         double mInsert,
+                         double mDelete,
+                         int thread_count,
+                         int program_type)
+{
+    if (program_type != 12) // 12 = B-link tree version
+    {
+        fprintf(stderr, "Only B-link tree version (program_type=12) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Convert the initial list outside the timed region
+    struct blink_tree_s tree;
+    blink_build(&tree, *list_head);
+
+    thread_params_t params = {&tree, m, mMember, mInsert, mDelete, thread_count};
+
+    printf("Running in B-link tree mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // Free the tree and the list
+    blink_destroy(&tree);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    return elapsed_time;
+}
@@ -0,0 +1,82 @@
+#include <sched.h>
+#include "dist_rwlock.h"
+
+#define SPINS_BEFORE_YIELD 64
+
+// Slot of the calling thread, assigned on first use
+static atomic_int next_slot = 0;
+static __thread int my_slot = -1;
+
+static inline dist_rwlock_slot_t *reader_slot(dist_rwlock_t *lock)
+{
+    if (my_slot < 0)
+        my_slot = atomic_fetch_add(&next_slot, 1) % DIST_RWLOCK_SLOTS;
+    return &lock->slots[my_slot];
+}
+
+// Spin briefly, then give the CPU away (threads may outnumber cores)
+static inline void backoff(int *spins)
+{
+    if (++(*spins) >= SPINS_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+void dist_rwlock_init(dist_rwlock_t *lock)
+{
+    for (int i = 0; i < DIST_RWLOCK_SLOTS; i++)
+        atomic_init(&lock->slots[i].readers, 0);
+    atomic_init(&lock->writer, 0);
+}
+
+void dist_rwlock_rdlock(dist_rwlock_t *lock)
+{
+    dist_rwlock_slot_t *slot = reader_slot(lock);
+    int spins = 0;
+
+    while (1)
+    {
+        // Writer preference: don't even announce while a writer is pending
+        while (atomic_load_explicit(&lock->writer, memory_order_relaxed))
+            backoff(&spins);
+
+        atomic_fetch_add(&slot->readers, 1);
+        if (!atomic_load(&lock->writer))
+            return;
+
+        // A writer arrived between the check and the announcement
+        atomic_fetch_sub(&slot->readers, 1);
+    }
+}
+
+void dist_rwlock_wrlock(dist_rwlock_t *lock)
+{
+    int spins = 0;
+
+    // Serialize writers on the flag; raising it also stops new readers
+    while (atomic_exchange(&lock->writer, 1))
+        while (atomic_load_explicit(&lock->writer, memory_order_relaxed))
+            backoff(&spins);
+
+    // Wait for readers already inside to leave
+    for (int i = 0; i < DIST_RWLOCK_SLOTS; i++)
+        while (atomic_load(&lock->slots[i].readers) != 0)
+            backoff(&spins);
+}
+
+void dist_rwlock_rdunlock(dist_rwlock_t *lock)
+{
+    atomic_fetch_sub_explicit(&reader_slot(lock)->readers, 1, memory_order_release);
+}
+
+void dist_rwlock_wrunlock(dist_rwlock_t *lock)
+{
+    atomic_store_explicit(&lock->writer, 0, memory_order_release);
+}
+
+void dist_rwlock_destroy(dist_rwlock_t *lock)
+{
+    (void)lock; // nothing allocated
+}
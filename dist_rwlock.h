@@ -0,0 +1,34 @@
+#ifndef DIST_RWLOCK_H
+#define DIST_RWLOCK_H
+
+#include <stdatomic.h>
+
+// Distributed ("big-reader") read-write lock with writer preference.
+// Each reader announces itself in a cache-line-padded slot picked from
+// its thread id, so readers on different slots never write the same
+// line. A writer raises a flag, which turns new readers away, and then
+// waits for every slot to drain.
+
+#define DIST_RWLOCK_SLOTS 64 // threads beyond this share slots (still correct)
+#define DIST_RWLOCK_CACHE_LINE 64
+
+typedef struct
+{
+    atomic_int readers;
+    char pad[DIST_RWLOCK_CACHE_LINE - sizeof(atomic_int)];
+} dist_rwlock_slot_t;
+
+typedef struct
+{
+    dist_rwlock_slot_t slots[DIST_RWLOCK_SLOTS];
+    _Alignas(DIST_RWLOCK_CACHE_LINE) atomic_int writer; // 1 while a writer waits or holds
+} dist_rwlock_t;
+
+void dist_rwlock_init(dist_rwlock_t *lock);
+void dist_rwlock_rdlock(dist_rwlock_t *lock);
+void dist_rwlock_rdunlock(dist_rwlock_t *lock);
+void dist_rwlock_wrlock(dist_rwlock_t *lock);
+void dist_rwlock_wrunlock(dist_rwlock_t *lock);
+void dist_rwlock_destroy(dist_rwlock_t *lock);
+
+#endif
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "duration.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "affinity.h"
+
+double run_duration = 0;
+double sample_interval = 0.1;
+atomic_int duration_stop = 0;
+
+struct duration_count_s
+{
+    atomic_ulong ops;
+} __attribute__((aligned(64))); // one line per worker
+
+static struct duration_count_s *counts = NULL;
+static int counts_capacity = 0;
+static int run_thread_count = 0;
+
+// Sampler thread and the start signal it waits for
+static pthread_t sampler_thread;
+static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static int ops_started = 0;
+
+// Interval samples of the current run, in ops/s
+static double *run_samples = NULL;
+static int run_num_samples = 0;
+static int max_samples = 0;
+
+// Case totals
+static int case_runs = 0;
+static double case_ops = 0;
+static double *case_thread_rate = NULL; // summed per-thread ops/s, per worker index
+static int case_threads_capacity = 0;
+static double *case_sample_rate = NULL; // summed interval ops/s, per interval
+static int *case_sample_runs = NULL;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long total_ops(void)
+{
+    unsigned long total = 0;
+    for (int t = 0; t < run_thread_count; t++)
+        total += atomic_load_explicit(&counts[t].ops, memory_order_relaxed);
+    return total;
+}
+
+static void sleep_until(double when)
+{
+    double left = when - now_s();
+    if (left <= 0)
+        return;
+    struct timespec ts = {(time_t)left, (long)((left - (time_t)left) * 1e9)};
+    nanosleep(&ts, NULL);
+}
+
+static void *sampler(void *args)
+{
+    (void)args;
+    // Created from the main thread, which sits on worker 0's CPU
+    affinity_unpin_thread();
+    pthread_mutex_lock(&start_mutex);
+    while (!ops_started)
+        pthread_cond_wait(&start_cond, &start_mutex);
+    pthread_mutex_unlock(&start_mutex);
+
+    double start = now_s(), stop = start + run_duration;
+    double last_time = start;
+    unsigned long last_ops = 0;
+    while (run_num_samples < max_samples)
+    {
+        double next = last_time + sample_interval;
+        sleep_until(next < stop ? next : stop);
+
+        double now = now_s();
+        unsigned long ops = total_ops();
+        if (now > last_time)
+            run_samples[run_num_samples++] = (ops - last_ops) / (now - last_time);
+        last_time = now;
+        last_ops = ops;
+        if (now >= stop)
+            break;
+    }
+    atomic_store(&duration_stop, 1);
+    return NULL;
+}
+
+void duration_count_ops(int ops)
+{
+    // Only the owner writes its counter; the sampler reads it
+    int thread = thread_pool_index();
+    if (thread < 0)
+        thread = 0; // the serial version runs on the main thread
+    atomic_ulong *count = &counts[thread].ops;
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + ops, memory_order_relaxed);
+}
+
+void duration_ops_started(void)
+{
+    if (run_duration <= 0)
+        return;
+    pthread_mutex_lock(&start_mutex);
+    ops_started = 1;
+    pthread_cond_signal(&start_cond);
+    pthread_mutex_unlock(&start_mutex);
+}
+
+void duration_run_begin(int thread_count)
+{
+    if (run_duration <= 0)
+        return;
+
+    if (thread_count > counts_capacity)
+    {
+        free(counts);
+        counts = aligned_alloc(64, thread_count * sizeof(struct duration_count_s));
+        counts_capacity = thread_count;
+    }
+    for (int t = 0; t < thread_count; t++)
+        atomic_init(&counts[t].ops, 0);
+    run_thread_count = thread_count;
+
+    // One sample per interval, plus one for a short last interval
+    int needed = (int)(run_duration / sample_interval) + 2;
+    if (needed > max_samples)
+    {
+        run_samples = realloc(run_samples, needed * sizeof(double));
+        case_sample_rate = realloc(case_sample_rate, needed * sizeof(double));
+        case_sample_runs = realloc(case_sample_runs, needed * sizeof(int));
+        for (int i = max_samples; i < needed; i++)
+        {
+            case_sample_rate[i] = 0;
+            case_sample_runs[i] = 0;
+        }
+        max_samples = needed;
+    }
+    run_num_samples = 0;
+
+    atomic_store(&duration_stop, 0);
+    ops_started = 0;
+    if (pthread_create(&sampler_thread, NULL, sampler, NULL) != 0)
+    {
+        fprintf(stderr, "Failed to start the throughput sampler\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void duration_run_end(double elapsed_us)
+{
+    if (run_duration <= 0)
+        return;
+    pthread_join(sampler_thread, NULL);
+
+    if (run_thread_count > case_threads_capacity)
+    {
+        case_thread_rate = realloc(case_thread_rate, run_thread_count * sizeof(double));
+        for (int t = case_threads_capacity; t < run_thread_count; t++)
+            case_thread_rate[t] = 0;
+        case_threads_capacity = run_thread_count;
+    }
+
+    // Every thread ran for the same time, so Jain's index over the
+    // completed operations is the fairness of per-thread throughput
+    double sum = 0, sum_sq = 0;
+    for (int t = 0; t < run_thread_count; t++)
+    {
+        double ops = atomic_load(&counts[t].ops);
+        sum += ops;
+        sum_sq += ops * ops;
+        if (elapsed_us > 0)
+            case_thread_rate[t] += ops / elapsed_us * 1e6;
+    }
+    run_fairness = sum_sq > 0 ? (sum * sum) / (run_thread_count * sum_sq) : 1.0;
+    case_ops += sum;
+
+    for (int i = 0; i < run_num_samples; i++)
+    {
+        case_sample_rate[i] += run_samples[i];
+        case_sample_runs[i]++;
+    }
+    case_runs++;
+}
+
+void duration_case_reset(void)
+{
+    case_runs = 0;
+    case_ops = 0;
+    for (int t = 0; t < case_threads_capacity; t++)
+        case_thread_rate[t] = 0;
+    for (int i = 0; i < max_samples; i++)
+    {
+        case_sample_rate[i] = 0;
+        case_sample_runs[i] = 0;
+    }
+}
+
+double duration_case_ops_per_run(void)
+{
+    return case_runs > 0 ? case_ops / case_runs : 0;
+}
+
+void duration_case_print(int thread_count)
+{
+    if (run_duration <= 0 || case_runs == 0)
+        return;
+
+    printf("Completed operations per run: %.0f\n", case_ops / case_runs);
+    if (thread_count > 1)
+    {
+        printf("Per-thread throughput (ops/s):");
+        for (int t = 0; t < thread_count && t < case_threads_capacity; t++)
+            printf(" %.0f", case_thread_rate[t] / case_runs);
+        printf("\n");
+    }
+
+    // Averaged over the runs; a falling series means throughput collapses
+    printf("Interval throughput (ops/s every %.3g s):", sample_interval);
+    for (int i = 0; i < max_samples && case_sample_runs[i] > 0; i++)
+        printf(" %.0f", case_sample_rate[i] / case_sample_runs[i]);
+    printf("\n");
+}
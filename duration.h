@@ -0,0 +1,54 @@
+#ifndef DURATION_H
+#define DURATION_H
+
+#include <stdatomic.h>
+
+// Fixed-duration mode (--duration=T). Instead of working through its m /
+// thread_count operations once, every worker cycles over its operation
+// stream until a stop flag is set, counting the operations it completes.
+// A sampler thread starts its clock when the last worker passes the
+// start barrier, records the throughput every sample_interval seconds
+// and sets the stop flag after run_duration seconds.
+
+// Seconds per run; 0 (the default) runs a fixed number of operations
+extern double run_duration;
+// Seconds between throughput samples
+extern double sample_interval;
+// Set when the workers have to leave their operation loop
+extern atomic_int duration_stop;
+
+// Add ops completed operations to the calling worker's count
+void duration_count_ops(int ops);
+
+// Loop condition of every operation loop: for (int i = 0;
+// duration_more_ops(&i, total, step); i += step). With a fixed operation
+// count this is i < total; in fixed-duration mode it wraps i back to the
+// start of the stream and runs until duration_stop is set.
+static inline int duration_more_ops(int *i, int total, int step)
+{
+    if (run_duration <= 0)
+        return *i < total;
+    if (total == 0 || atomic_load_explicit(&duration_stop, memory_order_relaxed))
+        return 0;
+    if (*i >= total)
+        *i = 0; // start the stream over
+    duration_count_ops(total - *i < step ? total - *i : step);
+    return 1;
+}
+
+// Called once when the operation phase starts; starts the sampler's clock
+void duration_ops_started(void);
+
+// Around every run: reset the counts and start the sampler, then stop it
+// and add the run (elapsed_us long) to the case totals. In fixed-duration
+// mode run_end also sets run_fairness from the per-thread counts.
+void duration_run_begin(int thread_count);
+void duration_run_end(double elapsed_us);
+
+// Case totals: clear them, average completed operations per run, and
+// print per-thread throughput and the interval samples
+void duration_case_reset(void);
+double duration_case_ops_per_run(void);
+void duration_case_print(int thread_count);
+
+#endif
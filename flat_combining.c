@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// Flat combining: threads publish their operation in a private slot and
+// whichever thread wins the combiner lock applies every pending request
+// in one sorted pass over the list (ApplyBatch), writing results back
+// into the slots.
+// The list itself is the plain linkedlist.c list, touched only by the
+// current combiner.
+
+#define CACHE_LINE 64
+#define SPINS_BEFORE_YIELD 64
+
+enum
+{
+    FC_NONE = 0,
+    FC_INSERT = LIST_OP_INSERT + 1,
+    FC_DELETE = LIST_OP_DELETE + 1,
+    FC_MEMBER = LIST_OP_MEMBER + 1
+};
+
+// One publication slot per thread, alone on its cache line
+typedef struct
+{
+    atomic_int op; // FC_NONE once the combiner has served the request
+    int key;
+    int result;
+} __attribute__((aligned(CACHE_LINE))) fc_slot_t;
+
+typedef struct
+{
+    struct list_node_s **head;
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    fc_slot_t *slots;
+    _Alignas(CACHE_LINE) atomic_int combiner_lock;
+    atomic_int next_id;
+    // Written only by the combiner
+    long passes;   // combining passes
+    long combined; // requests served by those passes
+} thread_params_t;
+
+// Serve every pending request with one ApplyBatch traversal
+static void fc_combine(thread_params_t *params)
+{
+    struct list_op_s batch[params->thread_count];
+    int owner[params->thread_count]; // slot of each request, by submission order
+    int count = 0;
+
+    for (int i = 0; i < params->thread_count; i++)
+    {
+        int op = atomic_load_explicit(&params->slots[i].op, memory_order_acquire);
+        if (op != FC_NONE)
+        {
+            batch[count].op = op - 1; // FC_* codes are LIST_OP_* + 1
+            batch[count].value = params->slots[i].key;
+            owner[count] = i;
+            count++;
+        }
+    }
+
+    SortBatch(batch, count);
+    ApplyBatch(batch, count, params->head);
+
+    for (int i = 0; i < count; i++)
+    {
+        fc_slot_t *slot = &params->slots[owner[batch[i].seq]];
+        slot->result = batch[i].result;
+        atomic_store_explicit(&slot->op, FC_NONE, memory_order_release);
+    }
+
+    params->passes++;
+    params->combined += count;
+}
+
+// Publish one request and wait until some combiner (maybe us) has served it
+static int fc_execute(thread_params_t *params, fc_slot_t *slot, int op, int value)
+{
+    slot->key = value;
+    atomic_store_explicit(&slot->op, op, memory_order_release);
+
+    int spins = 0;
+    while (atomic_load_explicit(&slot->op, memory_order_acquire) != FC_NONE)
+    {
+        if (!atomic_load_explicit(&params->combiner_lock, memory_order_relaxed) &&
+            !atomic_exchange_explicit(&params->combiner_lock, 1, memory_order_acquire))
+        {
+            fc_combine(params);
+            atomic_store_explicit(&params->combiner_lock, 0, memory_order_release);
+            continue;
+        }
+
+        // Someone else is combining; our request may be in their batch
+        if (++spins >= SPINS_BEFORE_YIELD)
+        {
+            spins = 0;
+            sched_yield();
+        }
+    }
+    return slot->result;
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+    fc_slot_t *slot = &params->slots[atomic_fetch_add(&params->next_id, 1)];
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations through the combiner
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            fc_execute(params, slot, FC_INSERT, val);
+        else if (op == 1)
+            fc_execute(params, slot, FC_DELETE, val);
+        else
+            fc_execute(params, slot, FC_MEMBER, val);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_fc(struct list_node_s **list_head,
+                      int m,
+                      double mMember,
+                      double mInsert,
+                      double mDelete,
+                      int thread_count,
+                      int program_type)
+{
+    if (program_type != 11) // 11 = flat combining version
+    {
+        fprintf(stderr, "Only flat combining version (program_type=11) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    thread_params_t params = {list_head, m, mMember, mInsert, mDelete, thread_count};
+    params.slots = aligned_alloc(CACHE_LINE, thread_count * sizeof(fc_slot_t));
+    for (int i = 0; i < thread_count; i++)
+        atomic_init(&params.slots[i].op, FC_NONE);
+    atomic_init(&params.combiner_lock, 0);
+    atomic_init(&params.next_id, 0);
+    params.passes = 0;
+    params.combined = 0;
+
+    printf("Running in flat combining mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // Lock transfers are one per pass instead of one per operation
+    printf("  %ld combining passes, %.2f requests per pass\n",
+           params.passes, params.passes ? (double)params.combined / params.passes : 0.0);
+
+    // Free the list
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+    free(params.slots);
+
+    return elapsed_time;
+}
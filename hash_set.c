@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// Lock-striped hash set (Herlihy and Shavit's striped hash set) with
+// incremental resizing. Buckets are chains of list nodes. Bucket b of
+// every table is guarded by stripe b mod HS_STRIPES. Table sizes are
+// powers of two no smaller than HS_STRIPES, so when a table doubles,
+// bucket b splits into buckets b and b + size under the same stripe.
+// A resize only allocates the new table. Buckets then move one at a
+// time: a thread that touches an unmoved bucket moves it first, and
+// every update also moves the next HS_MIGRATE_STEP unclaimed buckets.
+
+#define CACHE_LINE 64
+#define HS_STRIPES 256     // power of two
+#define HS_MAX_LOAD 2      // keys per bucket that trigger a resize
+#define HS_MIGRATE_STEP 2  // extra buckets each update moves during a resize
+#define SPINS_BEFORE_YIELD 64
+
+struct hs_stripe_s
+{
+    atomic_int held;
+    int count; // keys in the buckets of this stripe, guarded by held
+} __attribute__((aligned(CACHE_LINE)));
+
+struct hs_table_s
+{
+    int size; // buckets, a power of two
+    struct list_node_s **buckets;
+    // Set while this table's keys are still partly in prev
+    _Atomic(struct hs_table_s *) prev;
+    unsigned char *moved;    // per bucket of prev, guarded by its stripe
+    atomic_int next_claim;   // next bucket of prev for a helper to move
+    atomic_int moved_count;
+    struct hs_table_s *retired_next; // chain of replaced tables, freed after the run
+};
+
+struct hash_set_s
+{
+    _Atomic(struct hs_table_s *) table;
+    atomic_int resizing; // one thread allocates the next table
+    struct hs_stripe_s stripes[HS_STRIPES];
+    struct hs_table_s *retired;
+    int resizes;
+};
+
+typedef struct
+{
+    struct hash_set_s *set;
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+} thread_params_t;
+
+// murmur3 finalizer; the low bits pick both the bucket and the stripe
+static inline uint32_t hs_hash(int key)
+{
+    uint32_t h = (uint32_t)key;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+// Spin briefly, then give the CPU away (threads may outnumber cores)
+static inline void backoff(int *spins)
+{
+    if (++(*spins) >= SPINS_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+static void hs_lock(struct hs_stripe_s *stripe)
+{
+    int spins = 0;
+    while (atomic_exchange_explicit(&stripe->held, 1, memory_order_acquire))
+        while (atomic_load_explicit(&stripe->held, memory_order_relaxed))
+            backoff(&spins);
+}
+
+static void hs_unlock(struct hs_stripe_s *stripe)
+{
+    atomic_store_explicit(&stripe->held, 0, memory_order_release);
+}
+
+static struct hs_table_s *hs_new_table(int size, struct hs_table_s *prev)
+{
+    struct hs_table_s *table = malloc(sizeof(struct hs_table_s));
+    table->size = size;
+    table->buckets = calloc(size, sizeof(struct list_node_s *));
+    atomic_init(&table->prev, prev);
+    table->moved = prev != NULL ? calloc(prev->size, 1) : NULL;
+    atomic_init(&table->next_claim, 0);
+    atomic_init(&table->moved_count, 0);
+    table->retired_next = NULL;
+    return table;
+}
+
+// Move bucket b of table's previous table into table; the caller holds
+// b's stripe, which also guards both buckets it splits into
+static void hs_move_bucket(struct hs_table_s *table, struct hs_table_s *prev, int b)
+{
+    if (table->moved[b])
+        return;
+    struct list_node_s *curr_p = prev->buckets[b];
+    while (curr_p != NULL)
+    {
+        struct list_node_s *next = curr_p->next;
+        struct list_node_s **bucket = &table->buckets[hs_hash(curr_p->data) & (table->size - 1)];
+        curr_p->next = *bucket;
+        *bucket = curr_p;
+        curr_p = next;
+    }
+    prev->buckets[b] = NULL;
+    table->moved[b] = 1;
+
+    // The last bucket moved ends the resize
+    if (atomic_fetch_add(&table->moved_count, 1) + 1 == prev->size)
+        atomic_store(&table->prev, NULL);
+}
+
+// Lock the stripe of value and return the table whose bucket holds it,
+// moving the bucket out of the previous table first if needed
+static struct hs_table_s *hs_lock_bucket(struct hash_set_s *set, uint32_t hash)
+{
+    struct hs_stripe_s *stripe = &set->stripes[hash & (HS_STRIPES - 1)];
+    hs_lock(stripe);
+    // A resize that starts from here on needs this stripe to move the bucket
+    struct hs_table_s *table = atomic_load(&set->table);
+    struct hs_table_s *prev = atomic_load(&table->prev);
+    if (prev != NULL)
+        hs_move_bucket(table, prev, hash & (prev->size - 1));
+    return table;
+}
+
+// Move a few unclaimed buckets so a resize finishes even for keys nobody touches
+static void hs_help_resize(struct hash_set_s *set)
+{
+    struct hs_table_s *table = atomic_load(&set->table);
+    struct hs_table_s *prev = atomic_load(&table->prev);
+    if (prev == NULL)
+        return;
+    for (int i = 0; i < HS_MIGRATE_STEP; i++)
+    {
+        int b = atomic_fetch_add(&table->next_claim, 1);
+        if (b >= prev->size)
+            return;
+        struct hs_stripe_s *stripe = &set->stripes[b & (HS_STRIPES - 1)];
+        hs_lock(stripe);
+        hs_move_bucket(table, prev, b);
+        hs_unlock(stripe);
+    }
+}
+
+// Double the table once a stripe is over its share of the load; only
+// allocates, the buckets move incrementally
+static void hs_maybe_resize(struct hash_set_s *set, int stripe_count)
+{
+    struct hs_table_s *table = atomic_load(&set->table);
+    if (stripe_count <= HS_MAX_LOAD * (table->size / HS_STRIPES) || atomic_load(&table->prev) != NULL)
+        return;
+    if (atomic_exchange(&set->resizing, 1))
+        return;
+
+    // Recheck: another thread may have resized in between
+    table = atomic_load(&set->table);
+    if (atomic_load(&table->prev) == NULL)
+    {
+        struct hs_table_s *bigger = hs_new_table(table->size * 2, table);
+        table->retired_next = set->retired;
+        set->retired = table;
+        set->resizes++;
+        atomic_store(&set->table, bigger);
+    }
+    atomic_store(&set->resizing, 0);
+}
+
+static int hs_member(struct hash_set_s *set, int value)
+{
+    uint32_t hash = hs_hash(value);
+    struct hs_table_s *table = hs_lock_bucket(set, hash);
+    struct list_node_s *curr_p = table->buckets[hash & (table->size - 1)];
+    while (curr_p != NULL && curr_p->data != value)
+        curr_p = curr_p->next;
+    hs_unlock(&set->stripes[hash & (HS_STRIPES - 1)]);
+    return curr_p != NULL;
+}
+
+static int hs_insert(struct hash_set_s *set, int value)
+{
+    uint32_t hash = hs_hash(value);
+    struct hs_stripe_s *stripe = &set->stripes[hash & (HS_STRIPES - 1)];
+    struct hs_table_s *table = hs_lock_bucket(set, hash);
+    struct list_node_s **bucket = &table->buckets[hash & (table->size - 1)];
+    struct list_node_s *curr_p = *bucket;
+    while (curr_p != NULL && curr_p->data != value)
+        curr_p = curr_p->next;
+
+    int inserted = curr_p == NULL;
+    if (inserted)
+    {
+        struct list_node_s *temp_p = alloc_node();
+        temp_p->data = value;
+        temp_p->next = *bucket;
+        *bucket = temp_p;
+        stripe->count++;
+    }
+    int stripe_count = stripe->count;
+    hs_unlock(stripe);
+
+    hs_help_resize(set);
+    if (inserted)
+        hs_maybe_resize(set, stripe_count);
+    return inserted;
+}
+
+static int hs_delete(struct hash_set_s *set, int value)
+{
+    uint32_t hash = hs_hash(value);
+    struct hs_stripe_s *stripe = &set->stripes[hash & (HS_STRIPES - 1)];
+    struct hs_table_s *table = hs_lock_bucket(set, hash);
+    struct list_node_s **link_pp = &table->buckets[hash & (table->size - 1)];
+    while (*link_pp != NULL && (*link_pp)->data != value)
+        link_pp = &(*link_pp)->next;
+
+    int found = *link_pp != NULL;
+    if (found)
+    {
+        struct list_node_s *curr_p = *link_pp;
+        *link_pp = curr_p->next;
+        free_node(curr_p); // no other thread can reach it without this stripe
+        stripe->count--;
+    }
+    hs_unlock(stripe);
+
+    hs_help_resize(set);
+    return found;
+}
+
+// Fill the set from the initial list, sized so it starts below the resize threshold
+static void hs_build(struct hash_set_s *set, struct list_node_s *head_p, int count)
+{
+    int size = HS_STRIPES;
+    while (size * HS_MAX_LOAD < 2 * count)
+        size *= 2;
+    struct hs_table_s *table = hs_new_table(size, NULL);
+    atomic_init(&set->table, table);
+    atomic_init(&set->resizing, 0);
+    for (int s = 0; s < HS_STRIPES; s++)
+    {
+        atomic_init(&set->stripes[s].held, 0);
+        set->stripes[s].count = 0;
+    }
+    set->retired = NULL;
+    set->resizes = 0;
+
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        uint32_t hash = hs_hash(curr_p->data);
+        struct list_node_s *temp_p = alloc_node();
+        temp_p->data = curr_p->data;
+        temp_p->next = table->buckets[hash & (size - 1)];
+        table->buckets[hash & (size - 1)] = temp_p;
+        set->stripes[hash & (HS_STRIPES - 1)].count++;
+    }
+}
+
+static void hs_free_table(struct hs_table_s *table)
+{
+    for (int b = 0; b < table->size; b++)
+    {
+        struct list_node_s *curr_p = table->buckets[b];
+        while (curr_p != NULL)
+        {
+            struct list_node_s *next = curr_p->next;
+            free_node(curr_p);
+            curr_p = next;
+        }
+    }
+    free(table->buckets);
+    free(table->moved);
+    free(table);
+}
+
+// Free the current table and every replaced one; a resize still in
+// progress leaves keys in the newest replaced table
+static void hs_destroy(struct hash_set_s *set)
+{
+    hs_free_table(atomic_load(&set->table));
+    while (set->retired != NULL)
+    {
+        struct hs_table_s *next = set->retired->retired_next;
+        hs_free_table(set->retired);
+        set->retired = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, each under its key's stripe lock
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            hs_insert(params->set, val);
+        else if (op == 1)
+            hs_delete(params->set, val);
+        else
+            hs_member(params->set, val);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_hash(struct list_node_s **list_head,
+                        int m,
+                        double mMember,
+                        double mInsert,
+                        double mDelete,
+                        int thread_count,
+                        int program_type)
+{
+    if (program_type != 13) // 13 = hash set version
+    {
+        fprintf(stderr, "Only hash set version (program_type=13) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Convert the initial list outside the timed region
+    int count = 0;
+    for (struct list_node_s *curr_p = *list_head; curr_p != NULL; curr_p = curr_p->next)
+        count++;
+    static struct hash_set_s set; // stripes are padded; too large for the stack
+    hs_build(&set, *list_head, count);
+
+    thread_params_t params = {&set, m, mMember, mInsert, mDelete, thread_count};
+
+    printf("Running in hash set mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    struct hs_table_s *table = atomic_load(&set.table);
+    if (set.resizes > 0)
+        printf("Hash set resizes: %d, buckets: %d%s\n", set.resizes, table->size,
+               atomic_load(&table->prev) != NULL ? " (last resize unfinished)" : "");
+
+    // Free the hash set before the list: with --pool, destructor releases every node
+    hs_destroy(&set);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    return elapsed_time;
+}
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// Node structure with its own lock for hand-over-hand (lock coupling) traversal
+struct hoh_node_s
+{
+    int data;
+    struct hoh_node_s *next;
+    pthread_mutex_t mutex;
+};
+
+typedef struct
+{
+    struct hoh_node_s *sentinel; // head sentinel, never removed
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+} thread_params_t;
+
+static struct hoh_node_s *hoh_new_node(int value, struct hoh_node_s *next)
+{
+    struct hoh_node_s *node = malloc(sizeof(struct hoh_node_s));
+    node->data = value;
+    node->next = next;
+    pthread_mutex_init(&node->mutex, NULL);
+    return node;
+}
+
+static void hoh_free_node(struct hoh_node_s *node)
+{
+    pthread_mutex_destroy(&node->mutex);
+    free(node);
+}
+
+// Walk the list holding at most two locks at a time (pred and curr).
+// On return both *pred_pp and *curr_pp (if not NULL) are locked and
+// curr is the first node whose data is >= value.
+static void hoh_locate(int value, struct hoh_node_s *sentinel,
+                       struct hoh_node_s **pred_pp, struct hoh_node_s **curr_pp)
+{
+    struct hoh_node_s *pred_p = sentinel;
+    pthread_mutex_lock(&pred_p->mutex);
+    struct hoh_node_s *curr_p = pred_p->next;
+    if (curr_p != NULL)
+        pthread_mutex_lock(&curr_p->mutex);
+
+    while (curr_p != NULL && curr_p->data < value)
+    {
+        pthread_mutex_unlock(&pred_p->mutex);
+        pred_p = curr_p;
+        curr_p = curr_p->next;
+        if (curr_p != NULL)
+            pthread_mutex_lock(&curr_p->mutex);
+    }
+
+    *pred_pp = pred_p;
+    *curr_pp = curr_p;
+}
+
+static void hoh_release(struct hoh_node_s *pred_p, struct hoh_node_s *curr_p)
+{
+    if (curr_p != NULL)
+        pthread_mutex_unlock(&curr_p->mutex);
+    pthread_mutex_unlock(&pred_p->mutex);
+}
+
+static int hoh_member(int value, struct hoh_node_s *sentinel)
+{
+    struct hoh_node_s *pred_p, *curr_p;
+    hoh_locate(value, sentinel, &pred_p, &curr_p);
+
+    int found = (curr_p != NULL && curr_p->data == value);
+
+    hoh_release(pred_p, curr_p);
+    return found;
+}
+
+static int hoh_insert(int value, struct hoh_node_s *sentinel)
+{
+    struct hoh_node_s *pred_p, *curr_p;
+    hoh_locate(value, sentinel, &pred_p, &curr_p);
+
+    int inserted = 0;
+    if (curr_p == NULL || curr_p->data > value)
+    {
+        pred_p->next = hoh_new_node(value, curr_p);
+        inserted = 1;
+    }
+
+    hoh_release(pred_p, curr_p);
+    return inserted;
+}
+
+static int hoh_delete(int value, struct hoh_node_s *sentinel)
+{
+    struct hoh_node_s *pred_p, *curr_p;
+    hoh_locate(value, sentinel, &pred_p, &curr_p);
+
+    if (curr_p != NULL && curr_p->data == value)
+    {
+        // Holding pred's lock means no other thread can reach curr anymore
+        pred_p->next = curr_p->next;
+        pthread_mutex_unlock(&curr_p->mutex);
+        hoh_free_node(curr_p);
+        pthread_mutex_unlock(&pred_p->mutex);
+        return 1;
+    }
+
+    hoh_release(pred_p, curr_p);
+    return 0;
+}
+
+// Copy the (already sorted) initial list into lockable nodes
+static struct hoh_node_s *hoh_build(struct list_node_s *head_p)
+{
+    struct hoh_node_s *sentinel = hoh_new_node(INT_MIN, NULL);
+    struct hoh_node_s *tail = sentinel;
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        tail->next = hoh_new_node(curr_p->data, NULL);
+        tail = tail->next;
+    }
+    return sentinel;
+}
+
+static void hoh_destroy(struct hoh_node_s *sentinel)
+{
+    struct hoh_node_s *curr_p = sentinel;
+    while (curr_p != NULL)
+    {
+        struct hoh_node_s *next = curr_p->next;
+        hoh_free_node(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, locking only the nodes being traversed
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            hoh_insert(val, params->sentinel);
+        else if (op == 1)
+            hoh_delete(val, params->sentinel);
+        else
+            hoh_member(val, params->sentinel);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_hoh(struct list_node_s **list_head,
+                       int m,
+                       double mMember,
+                       double mInsert,
+                       double mDelete,
+                       int thread_count,
+                       int program_type)
+{
+    if (program_type != 3) // 3 = hand-over-hand locking version
+    {
+        fprintf(stderr, "Only hand-over-hand version (program_type=3) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    // Convert the initial list outside the timed region
+    struct hoh_node_s *sentinel = hoh_build(*list_head);
+
+    thread_params_t params = {sentinel, m, mMember, mInsert, mDelete,
+                              thread_count};
+
+    printf("Running in hand-over-hand mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // Free both lists
+    hoh_destroy(sentinel);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    return elapsed_time;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "key_dist.h"
+
+struct key_dist_s key_dist = {KEY_DIST_UNIFORM, 0.99, 0.2, 0.8};
+
+static const char *key_dist_names[NUM_KEY_DISTS] = {"uniform", "zipf", "hotspot", "asc", "desc"};
+
+// Set by key_dist_prepare, read-only while threads generate operations
+static int dist_range = 1;
+static double zipf_zetan, zipf_alpha, zipf_eta, zipf_half_pow;
+static uint64_t zipf_stride = 1; // rank -> key permutation
+static int hot_count = 1;
+
+static int gcd(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return (int)a;
+}
+
+int key_dist_parse(const char *spec, struct key_dist_s *dist)
+{
+    const char *params = strchr(spec, ':');
+    size_t name_len = params ? (size_t)(params - spec) : strlen(spec);
+
+    int kind = -1;
+    for (int k = 0; k < NUM_KEY_DISTS; k++)
+    {
+        if (strlen(key_dist_names[k]) == name_len && strncmp(spec, key_dist_names[k], name_len) == 0)
+            kind = k;
+    }
+    if (kind < 0)
+        return 0;
+    dist->kind = (key_dist_kind_t)kind;
+
+    if (params == NULL)
+        return 1;
+    if (kind == KEY_DIST_ZIPF)
+    {
+        char *end;
+        dist->theta = strtod(params + 1, &end);
+        return *end == '\0' && dist->theta > 0 && dist->theta < 1;
+    }
+    if (kind == KEY_DIST_HOTSPOT)
+    {
+        char *end;
+        dist->hot_keys = strtod(params + 1, &end);
+        if (*end != ':')
+            return 0;
+        dist->hot_ops = strtod(end + 1, &end);
+        return *end == '\0' && dist->hot_keys > 0 && dist->hot_keys < 1 &&
+               dist->hot_ops >= 0 && dist->hot_ops <= 1;
+    }
+    return 0; // the others take no parameters
+}
+
+void key_dist_describe(const struct key_dist_s *dist, char *buf, size_t len)
+{
+    if (dist->kind == KEY_DIST_ZIPF)
+        snprintf(buf, len, "zipf(%g)", dist->theta);
+    else if (dist->kind == KEY_DIST_HOTSPOT)
+        snprintf(buf, len, "hotspot(%g/%g)", dist->hot_keys, dist->hot_ops);
+    else
+        snprintf(buf, len, "%s", key_dist_names[dist->kind]);
+}
+
+void key_dist_prepare(int range)
+{
+    dist_range = range;
+
+    if (key_dist.kind == KEY_DIST_ZIPF)
+    {
+        // Constants of Gray et al., "Quickly Generating Billion-Record
+        // Synthetic Databases" (SIGMOD '94), as used by YCSB
+        double theta = key_dist.theta;
+        zipf_zetan = 0;
+        for (int i = 1; i <= range; i++)
+            zipf_zetan += 1.0 / pow(i, theta);
+        double zeta2 = 1.0 + 1.0 / pow(2, theta);
+        zipf_alpha = 1.0 / (1.0 - theta);
+        zipf_eta = (1.0 - pow(2.0 / range, 1.0 - theta)) / (1.0 - zeta2 / zipf_zetan);
+        zipf_half_pow = 1.0 + pow(0.5, theta);
+
+        // Rank r maps to key r * stride mod range, so the hottest keys are
+        // spread over the list rather than packed at its head
+        zipf_stride = (uint64_t)(range * 0.6180339887) | 1;
+        while (gcd(zipf_stride, range) != 1)
+            zipf_stride++;
+    }
+
+    if (key_dist.kind == KEY_DIST_HOTSPOT)
+    {
+        hot_count = (int)(key_dist.hot_keys * range);
+        if (hot_count < 1)
+            hot_count = 1;
+    }
+}
+
+static double uniform01(unsigned int *seed)
+{
+    return rand_r(seed) / ((double)RAND_MAX + 1.0);
+}
+
+uint32_t key_dist_next(int i, int thread_index, int thread_count, unsigned int *seed)
+{
+    int range = dist_range;
+    switch (key_dist.kind)
+    {
+    case KEY_DIST_ZIPF:
+    {
+        double u = uniform01(seed);
+        double uz = u * zipf_zetan;
+        long rank;
+        if (uz < 1.0)
+            rank = 0;
+        else if (uz < zipf_half_pow)
+            rank = 1;
+        else
+            rank = (long)(range * pow(zipf_eta * u - zipf_eta + 1.0, zipf_alpha));
+        if (rank >= range)
+            rank = range - 1;
+        return (uint32_t)((uint64_t)rank * zipf_stride % range);
+    }
+    case KEY_DIST_HOTSPOT:
+    {
+        if (hot_count >= range || uniform01(seed) < key_dist.hot_ops)
+            return rand_r(seed) % hot_count;
+        return hot_count + rand_r(seed) % (range - hot_count);
+    }
+    case KEY_DIST_ASC:
+    {
+        // Each thread starts at the bottom of its own slice
+        long start = (long)thread_index * range / thread_count;
+        return (uint32_t)((start + i) % range);
+    }
+    case KEY_DIST_DESC:
+    {
+        // Each thread starts at the top of its own slice
+        long top = (long)(thread_index + 1) * range / thread_count - 1;
+        return (uint32_t)(((top - i) % range + range) % range);
+    }
+    default:
+        return rand_r(seed) % range;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef KEY_DIST_H
+#define KEY_DIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Distribution of the keys the operations touch, picked at runtime
+// (--dist=SPEC). The initial population stays uniform; only the keys of
+// the generated operations follow the distribution.
+
+typedef enum
+{
+    KEY_DIST_UNIFORM, // every key in [0, key_range) equally likely
+    KEY_DIST_ZIPF,    // Zipfian with skew theta; hot keys scattered over the range
+    KEY_DIST_HOTSPOT, // hot_ops of the operations hit the lowest hot_keys of the range
+    KEY_DIST_ASC,     // each thread walks its slice of the range upwards
+    KEY_DIST_DESC,    // same, downwards
+    NUM_KEY_DISTS
+} key_dist_kind_t;
+
+struct key_dist_s
+{
+    key_dist_kind_t kind;
+    double theta;    // Zipf skew, 0 < theta < 1
+    double hot_keys; // hotspot: fraction of the key range that is hot
+    double hot_ops;  // hotspot: fraction of the operations that go to it
+};
+
+// Distribution used when generating operations; set by main.c
+extern struct key_dist_s key_dist;
+
+// Parse "uniform", "zipf[:THETA]", "hotspot[:KEYS:OPS]", "asc" or "desc";
+// returns 1 on success
+int key_dist_parse(const char *spec, struct key_dist_s *dist);
+
+// Short label without commas, e.g. "zipf(0.99)", for output and CSV rows
+void key_dist_describe(const struct key_dist_s *dist, char *buf, size_t len);
+
+// Precompute the constants for drawing keys from key_dist over
+// [0, range); call once before any thread generates operations
+void key_dist_prepare(int range);
+
+// Key of the i-th operation of thread thread_index out of thread_count
+uint32_t key_dist_next(int i, int thread_index, int thread_count, unsigned int *seed);
+
+#endif
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include "latency.h"
+#include "thread_pool.h"
+
+// Log-linear buckets in the style of HdrHistogram: values below 64 ns
+// get one bucket each, every power of two above that is split into 32,
+// so a bucket is never wider than about 3% of the values it holds
+#define LATENCY_SUB_BITS 6
+#define LATENCY_SUB (1 << LATENCY_SUB_BITS)
+#define LATENCY_HALF (LATENCY_SUB / 2)
+#define LATENCY_BUCKETS (LATENCY_SUB + (64 - LATENCY_SUB_BITS) * LATENCY_HALF)
+#define LATENCY_OP_TYPES 3 // LIST_OP_INSERT, LIST_OP_DELETE, LIST_OP_MEMBER
+
+struct latency_hist_s
+{
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[LATENCY_BUCKETS];
+} __attribute__((aligned(64)));
+
+int measure_latency = 0;
+
+static struct latency_hist_s *thread_hists = NULL; // LATENCY_OP_TYPES per worker
+static int thread_hists_capacity = 0;              // workers with room
+static int run_thread_count = 0;                    // workers in the current run
+static struct latency_hist_s case_hists[LATENCY_OP_TYPES];
+
+static int bucket_of(uint64_t ns)
+{
+    if (ns < LATENCY_SUB)
+        return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - (LATENCY_SUB_BITS - 1); // ns >> shift is in [HALF, SUB)
+    return LATENCY_SUB + (shift - 1) * LATENCY_HALF + (int)(ns >> shift) - LATENCY_HALF;
+}
+
+// Largest value that falls into bucket
+static uint64_t bucket_top(int bucket)
+{
+    if (bucket < LATENCY_SUB)
+        return bucket;
+    int shift = (bucket - LATENCY_SUB) / LATENCY_HALF + 1;
+    uint64_t mantissa = (bucket - LATENCY_SUB) % LATENCY_HALF + LATENCY_HALF;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+static void hist_add(struct latency_hist_s *hist, uint64_t ns)
+{
+    hist->buckets[bucket_of(ns)]++;
+    hist->count++;
+    if (ns > hist->max)
+        hist->max = ns;
+}
+
+void latency_add(int op, uint64_t ns)
+{
+    // The serial version runs on the main thread, outside the pool
+    int thread = thread_pool_index();
+    if (thread < 0)
+        thread = 0;
+    hist_add(&thread_hists[thread * LATENCY_OP_TYPES + op], ns);
+}
+
+void latency_record_batch(const struct list_op_s *batch, int count, uint64_t start)
+{
+    if (!measure_latency)
+        return;
+
+    // Every operation of the batch completes when the batch does
+    uint64_t ns = latency_now_ns() - start;
+    for (int i = 0; i < count; i++)
+        latency_add(batch[i].op, ns);
+}
+
+void latency_run_begin(int thread_count)
+{
+    if (!measure_latency)
+        return;
+
+    if (thread_count > thread_hists_capacity)
+    {
+        free(thread_hists);
+        thread_hists = aligned_alloc(64, (size_t)thread_count * LATENCY_OP_TYPES * sizeof(struct latency_hist_s));
+        thread_hists_capacity = thread_count;
+    }
+    memset(thread_hists, 0, (size_t)thread_count * LATENCY_OP_TYPES * sizeof(struct latency_hist_s));
+    run_thread_count = thread_count;
+}
+
+void latency_run_end(void)
+{
+    if (!measure_latency)
+        return;
+
+    for (int t = 0; t < run_thread_count; t++)
+    {
+        for (int op = 0; op < LATENCY_OP_TYPES; op++)
+        {
+            const struct latency_hist_s *src = &thread_hists[t * LATENCY_OP_TYPES + op];
+            struct latency_hist_s *dst = &case_hists[op];
+            if (src->count == 0)
+                continue;
+            for (int b = 0; b < LATENCY_BUCKETS; b++)
+                dst->buckets[b] += src->buckets[b];
+            dst->count += src->count;
+            if (src->max > dst->max)
+                dst->max = src->max;
+        }
+    }
+}
+
+void latency_case_reset(void)
+{
+    memset(case_hists, 0, sizeof(case_hists));
+}
+
+uint64_t latency_percentile(int op, double q)
+{
+    const struct latency_hist_s *hist = &case_hists[op];
+    if (hist->count == 0)
+        return 0;
+
+    // Smallest bucket holding at least q of the samples
+    uint64_t rank = (uint64_t)(q * hist->count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += hist->buckets[b];
+        if (seen >= rank)
+        {
+            uint64_t top = bucket_top(b);
+            return top < hist->max ? top : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+uint64_t latency_max(int op)
+{
+    return case_hists[op].max;
+}
@@ -0,0 +1,53 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <time.h>
+#include "linkedlist.h"
+
+// Per-operation latency histograms (--latency). Every worker records into
+// its own log-linear histograms, one per op type (LIST_OP_*), so the
+// timed loop takes no lock and shares no cache line. After a run the
+// per-thread histograms are merged into totals for the current case.
+
+// Nonzero when --latency is given; set by main.c
+extern int measure_latency;
+
+static inline uint64_t latency_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Start time of an operation, or 0 when latencies are not measured
+static inline uint64_t latency_start(void)
+{
+    return measure_latency ? latency_now_ns() : 0;
+}
+
+// Add one sample of ns nanoseconds for op to the calling thread's histogram
+void latency_add(int op, uint64_t ns);
+
+// Record an operation that started at start
+static inline void latency_record(int op, uint64_t start)
+{
+    if (measure_latency)
+        latency_add(op, latency_now_ns() - start);
+}
+
+// Record every operation of a batch that started at start
+void latency_record_batch(const struct list_op_s *batch, int count, uint64_t start);
+
+// Clear the histograms of thread_count workers before a run, and merge
+// them into the case totals after it
+void latency_run_begin(int thread_count);
+void latency_run_end(void);
+
+// Case totals: clear them, and read the q-th quantile (0 < q <= 1) or the
+// maximum of op in nanoseconds (0 without samples)
+void latency_case_reset(void);
+uint64_t latency_percentile(int op, double q);
+uint64_t latency_max(int op);
+
+#endif
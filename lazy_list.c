@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "qsbr.h"
+
+// Unlinked nodes are retired to qsbr.c and freed during the run, once
+// every thread has finished an operation after the unlink.
+
+// Node structure for the lazy list: a per-node lock for writers and a
+// "marked" bit that logically deletes the node before it is unlinked
+struct lazy_node_s
+{
+    int data;
+    _Atomic(struct lazy_node_s *) next;
+    atomic_int marked;
+    pthread_mutex_t mutex;
+    qsbr_entry_t retire; // grace period and chain while awaiting free
+};
+
+typedef struct
+{
+    struct lazy_node_s *head; // INT_MIN sentinel
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    qsbr_domain_t qsbr;
+} thread_params_t;
+
+static struct lazy_node_s *lazy_new_node(int value, struct lazy_node_s *next)
+{
+    struct lazy_node_s *node = malloc(sizeof(struct lazy_node_s));
+    node->data = value;
+    atomic_init(&node->next, next);
+    atomic_init(&node->marked, 0);
+    pthread_mutex_init(&node->mutex, NULL);
+    return node;
+}
+
+static void lazy_free_node(struct lazy_node_s *node)
+{
+    pthread_mutex_destroy(&node->mutex);
+    free(node);
+}
+
+static void lazy_free_entry(qsbr_entry_t *entry)
+{
+    lazy_free_node((struct lazy_node_s *)((char *)entry - offsetof(struct lazy_node_s, retire)));
+}
+
+// Lock-free search: pred is the last node with data < value, curr the first with data >= value
+static void lazy_locate(int value, struct lazy_node_s *head,
+                        struct lazy_node_s **pred_pp, struct lazy_node_s **curr_pp)
+{
+    struct lazy_node_s *pred_p = head;
+    struct lazy_node_s *curr_p = atomic_load_explicit(&pred_p->next, memory_order_acquire);
+    while (curr_p->data < value)
+    {
+        pred_p = curr_p;
+        curr_p = atomic_load_explicit(&curr_p->next, memory_order_acquire);
+    }
+    *pred_pp = pred_p;
+    *curr_pp = curr_p;
+}
+
+// Both nodes locked: still reachable and still adjacent?
+static int lazy_validate(struct lazy_node_s *pred_p, struct lazy_node_s *curr_p)
+{
+    return !atomic_load_explicit(&pred_p->marked, memory_order_relaxed) &&
+           !atomic_load_explicit(&curr_p->marked, memory_order_relaxed) &&
+           atomic_load_explicit(&pred_p->next, memory_order_relaxed) == curr_p;
+}
+
+// Membership: no locks and no shared writes
+static int lazy_member(int value, struct lazy_node_s *head)
+{
+    struct lazy_node_s *curr_p = head;
+    while (curr_p->data < value)
+        curr_p = atomic_load_explicit(&curr_p->next, memory_order_acquire);
+
+    return curr_p->data == value && !atomic_load_explicit(&curr_p->marked, memory_order_acquire);
+}
+
+static int lazy_insert(int value, struct lazy_node_s *head)
+{
+    while (1)
+    {
+        struct lazy_node_s *pred_p, *curr_p;
+        lazy_locate(value, head, &pred_p, &curr_p);
+
+        pthread_mutex_lock(&pred_p->mutex);
+        pthread_mutex_lock(&curr_p->mutex);
+
+        if (lazy_validate(pred_p, curr_p))
+        {
+            int inserted = 0;
+            if (curr_p->data != value)
+            {
+                struct lazy_node_s *temp_p = lazy_new_node(value, curr_p);
+                atomic_store_explicit(&pred_p->next, temp_p, memory_order_release);
+                inserted = 1;
+            }
+            pthread_mutex_unlock(&curr_p->mutex);
+            pthread_mutex_unlock(&pred_p->mutex);
+            return inserted;
+        }
+
+        // Raced with a concurrent writer, retry from the head
+        pthread_mutex_unlock(&curr_p->mutex);
+        pthread_mutex_unlock(&pred_p->mutex);
+    }
+}
+
+static int lazy_delete(qsbr_thread_t *t, int value, struct lazy_node_s *head)
+{
+    while (1)
+    {
+        struct lazy_node_s *pred_p, *curr_p;
+        lazy_locate(value, head, &pred_p, &curr_p);
+
+        pthread_mutex_lock(&pred_p->mutex);
+        pthread_mutex_lock(&curr_p->mutex);
+
+        if (lazy_validate(pred_p, curr_p))
+        {
+            int deleted = 0;
+            if (curr_p->data == value)
+            {
+                // Logical delete first, then physical unlink
+                atomic_store_explicit(&curr_p->marked, 1, memory_order_release);
+                atomic_store_explicit(&pred_p->next,
+                                      atomic_load_explicit(&curr_p->next, memory_order_relaxed),
+                                      memory_order_release);
+                // Readers may still be standing on curr: defer the free
+                qsbr_retire(t, &curr_p->retire);
+                deleted = 1;
+            }
+            pthread_mutex_unlock(&curr_p->mutex);
+            pthread_mutex_unlock(&pred_p->mutex);
+            return deleted;
+        }
+
+        pthread_mutex_unlock(&curr_p->mutex);
+        pthread_mutex_unlock(&pred_p->mutex);
+    }
+}
+
+// Copy the (already sorted) initial list between the two sentinels
+static struct lazy_node_s *lazy_build(struct list_node_s *head_p)
+{
+    struct lazy_node_s *head = lazy_new_node(INT_MIN, NULL);
+    struct lazy_node_s *tail = head;
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        struct lazy_node_s *node = lazy_new_node(curr_p->data, NULL);
+        atomic_store_explicit(&tail->next, node, memory_order_relaxed);
+        tail = node;
+    }
+    atomic_store_explicit(&tail->next, lazy_new_node(INT_MAX, NULL), memory_order_relaxed);
+    return head;
+}
+
+static void lazy_destroy(struct lazy_node_s *head)
+{
+    struct lazy_node_s *curr_p = head;
+    while (curr_p != NULL)
+    {
+        struct lazy_node_s *next = atomic_load_explicit(&curr_p->next, memory_order_relaxed);
+        lazy_free_node(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    qsbr_thread_t self;
+    qsbr_thread_init(&self, &params->qsbr);
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, readers never lock
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            lazy_insert(val, params->head);
+        else if (op == 1)
+            lazy_delete(&self, val, params->head);
+        else
+            lazy_member(val, params->head);
+
+        qsbr_quiescent_state(&self);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    qsbr_thread_offline(&self);
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_lazy(struct list_node_s **list_head,
+                        int m,
+                        double mMember,
+                        double mInsert,
+                        double mDelete,
+                        int thread_count,
+                        int program_type)
+{
+    if (program_type != 4) // 4 = lazy list version
+    {
+        fprintf(stderr, "Only lazy list version (program_type=4) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    // Convert the initial list outside the timed region
+    struct lazy_node_s *head = lazy_build(*list_head);
+
+    thread_params_t params = {head, m, mMember, mInsert, mDelete, thread_count};
+    qsbr_init(&params.qsbr, thread_count, lazy_free_entry);
+
+    printf("Running in lazy list mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    qsbr_destroy(&params.qsbr);
+
+    // Free both lists
+    lazy_destroy(head);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    return elapsed_time;
+}
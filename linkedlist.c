@@ -2,11 +2,41 @@
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 #include "linkedlist.h"
+#include "node_pool.h"
+#include "affinity.h"
 
 // Global list head
 struct list_node_s* head = NULL;
 
+// Block of the list built by BuildList
+static struct list_node_s* bulk_nodes = NULL;
+static int bulk_count = 0;
+
+static int in_bulk(struct list_node_s* node) {
+    return node >= bulk_nodes && node < bulk_nodes + bulk_count;
+}
+
+// Node allocation
+struct list_node_s* alloc_node(void) {
+    if (use_node_pool) {
+        return node_pool_alloc();
+    }
+    return malloc(sizeof(struct list_node_s));
+}
+
+void free_node(struct list_node_s* node) {
+    if (in_bulk(node)) { /* Freed with its block by destructor */
+        return;
+    }
+    if (use_node_pool) {
+        node_pool_free(node);
+    } else {
+        free(node);
+    }
+}
+
 // Membership
 int Member(int value, struct list_node_s* head_p) {
     struct list_node_s* curr_p = head_p;
@@ -34,7 +64,7 @@ int Insert(int value, struct list_node_s** head_pp) {
     }
 
     if (curr_p == NULL || curr_p->data > value) {
-        temp_p = malloc(sizeof(struct list_node_s));
+        temp_p = alloc_node();
         temp_p->data = value;
         temp_p->next = curr_p;
         if (pred_p == NULL) { /* New first node */
@@ -61,10 +91,10 @@ int Delete(int value, struct list_node_s** head_pp) {
     if (curr_p != NULL && curr_p->data == value) {
         if (pred_p == NULL) { /* Deleting first node */
             *head_pp = curr_p->next;
-            free(curr_p);
+            free_node(curr_p);
         } else {
             pred_p->next = curr_p->next;
-            free(curr_p);
+            free_node(curr_p);
         }
         return 1;
     } else { /* Value not found */
@@ -72,14 +102,149 @@ int Delete(int value, struct list_node_s** head_pp) {
     }
 }
 
+// Batch ordering: by value, then by submission order
+static int compare_ops(const void* a, const void* b) {
+    const struct list_op_s* op_a = a;
+    const struct list_op_s* op_b = b;
+    if (op_a->value != op_b->value) {
+        return op_a->value < op_b->value ? -1 : 1;
+    }
+    return op_a->seq - op_b->seq;
+}
+
+// Sort a batch for ApplyBatch; callers can do this before taking a lock
+void SortBatch(struct list_op_s* ops, int count) {
+    for (int i = 0; i < count; i++) {
+        ops[i].seq = i;
+    }
+    qsort(ops, count, sizeof(struct list_op_s), compare_ops);
+}
+
+// Apply a batch in one pass from the head; each op's result is what the
+// single-key Member/Insert/Delete would have returned, in submission order
+void ApplyBatch(struct list_op_s* ops, int count, struct list_node_s** head_pp) {
+    int sorted = 1;
+    for (int i = 1; i < count && sorted; i++) {
+        if (ops[i - 1].value > ops[i].value) {
+            sorted = 0;
+        }
+    }
+    if (!sorted) {
+        SortBatch(ops, count);
+    }
+
+    struct list_node_s** link_pp = head_pp; /* link that points at curr */
+    for (int i = 0; i < count; i++) {
+        int value = ops[i].value;
+        while (*link_pp != NULL && (*link_pp)->data < value) {
+            link_pp = &(*link_pp)->next;
+        }
+
+        int found = (*link_pp != NULL && (*link_pp)->data == value);
+        if (ops[i].op == LIST_OP_INSERT) {
+            if (!found) {
+                struct list_node_s* temp_p = alloc_node();
+                temp_p->data = value;
+                temp_p->next = *link_pp;
+                *link_pp = temp_p;
+            }
+            ops[i].result = !found;
+        } else if (ops[i].op == LIST_OP_DELETE) {
+            if (found) {
+                struct list_node_s* curr_p = *link_pp;
+                *link_pp = curr_p->next;
+                free_node(curr_p);
+            }
+            ops[i].result = found;
+        } else {
+            ops[i].result = found;
+        }
+    }
+}
+
+// One build thread's share of the block
+struct build_chunk_s {
+    const int* keys;
+    int first, last; /* nodes [first, last) */
+    int index;       /* build thread index, placed like the worker of that index */
+};
+
+static void* build_chunk(void* args) {
+    struct build_chunk_s* chunk = args;
+    if (chunk->index > 0) {
+        /* Created from the pinned main thread: take worker index's CPU
+           instead of sharing worker 0's */
+        affinity_pin_thread(chunk->index);
+    }
+    for (int i = chunk->first; i < chunk->last; i++) {
+        bulk_nodes[i].data = chunk->keys[i];
+        bulk_nodes[i].next = i + 1 < bulk_count ? &bulk_nodes[i + 1] : NULL;
+    }
+    return NULL;
+}
+
+// Bulk construction: O(n), no per-node allocation and no traversal
+struct list_node_s* BuildList(const int* keys, int count, int threads) {
+    if (count == 0) {
+        return NULL;
+    }
+    bulk_nodes = malloc(count * sizeof(struct list_node_s));
+    if (bulk_nodes == NULL) {
+        fprintf(stderr, "BuildList: out of memory for %d nodes\n", count);
+        exit(EXIT_FAILURE);
+    }
+    bulk_count = count;
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > count) {
+        threads = count;
+    }
+    pthread_t* tids = malloc(threads * sizeof(pthread_t));
+    struct build_chunk_s* chunks = malloc(threads * sizeof(struct build_chunk_s));
+    for (int t = 0; t < threads; t++) {
+        chunks[t].keys = keys;
+        chunks[t].first = (int)((long)count * t / threads);
+        chunks[t].last = (int)((long)count * (t + 1) / threads);
+        chunks[t].index = t;
+    }
+    /* Each thread first-touches its own part of the block; chunks without
+       a thread are filled by the caller */
+    int spawned = 1;
+    while (spawned < threads && pthread_create(&tids[spawned], NULL, build_chunk, &chunks[spawned]) == 0) {
+        spawned++;
+    }
+    build_chunk(&chunks[0]);
+    for (int t = spawned; t < threads; t++) {
+        build_chunk(&chunks[t]);
+    }
+    for (int t = 1; t < spawned; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    free(tids);
+    free(chunks);
+    return bulk_nodes;
+}
+
 // Destructor to free all nodes
 void destructor(struct list_node_s* head) {
-    struct list_node_s* curr_p = head;
-    while (curr_p != NULL) {
-        struct list_node_s* next = curr_p->next;
-        free(curr_p);
-        curr_p = next;
+    if (use_node_pool) { /* Every other node lives in a pool slab */
+        node_pool_release_all();
+    } else {
+        struct list_node_s* curr_p = head;
+        while (curr_p != NULL) {
+            struct list_node_s* next = curr_p->next;
+            if (!in_bulk(curr_p)) {
+                free(curr_p);
+            }
+            curr_p = next;
+        }
     }
+
+    free(bulk_nodes);
+    bulk_nodes = NULL;
+    bulk_count = 0;
 }
 
 
@@ -7,10 +7,35 @@ struct list_node_s {
     struct list_node_s* next;
 };
 
+// One operation of a batch; op codes match the workers' ops arrays
+#define LIST_OP_INSERT 0
+#define LIST_OP_DELETE 1
+#define LIST_OP_MEMBER 2
+
+struct list_op_s {
+    int op;
+    int value;
+    int seq;    // submission order, keeps same-value operations in order
+    int result; // filled in by ApplyBatch
+};
+
 // Function prototypes
 int Member(int value, struct list_node_s* head_p);
 int Insert(int value, struct list_node_s** head_pp);
 int Delete(int value, struct list_node_s** head_pp);
 void destructor(struct list_node_s* head);
 
+// Batched operations: sort by value, then apply in a single traversal
+void SortBatch(struct list_op_s* ops, int count);
+void ApplyBatch(struct list_op_s* ops, int count, struct list_node_s** head_pp);
+
+// Build the sorted list of count ascending keys in one pass. Every node
+// lives in one contiguous block, filled by threads threads; the block is
+// freed by destructor, and free_node leaves its nodes to it.
+struct list_node_s* BuildList(const int* keys, int count, int threads);
+
+// Node allocation, from malloc or the node pool depending on use_node_pool
+struct list_node_s* alloc_node(void);
+void free_node(struct list_node_s* node);
+
 #endif
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "list_lock.h"
+
+#define SPINS_BEFORE_YIELD 64 // waiters may outnumber cores, so don't spin forever
+#define TTAS_MIN_DELAY 16
+#define TTAS_MAX_DELAY 4096
+
+lock_kind_t lock_kind = LOCK_PTHREAD;
+
+static const char *lock_kind_names[NUM_LOCK_KINDS] = {"pthread", "ticket", "ttas", "mcs", "clh"};
+
+const char *lock_kind_name(lock_kind_t kind)
+{
+    return (kind >= 0 && kind < NUM_LOCK_KINDS) ? lock_kind_names[kind] : "unknown";
+}
+
+int lock_kind_from_name(const char *name, lock_kind_t *kind)
+{
+    for (int k = 0; k < NUM_LOCK_KINDS; k++)
+    {
+        if (strcmp(name, lock_kind_names[k]) == 0)
+        {
+            *kind = (lock_kind_t)k;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Spin a little, then yield so a preempted lock holder can run
+static inline void spin_wait(int *spins)
+{
+    if (++(*spins) >= SPINS_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+    else
+    {
+        cpu_relax();
+    }
+}
+
+static struct clh_node_s *clh_new_node(int locked)
+{
+    struct clh_node_s *node = aligned_alloc(LIST_LOCK_CACHE_LINE, sizeof(struct clh_node_s));
+    atomic_init(&node->locked, locked);
+    return node;
+}
+
+void list_lock_init(list_lock_t *lock, lock_kind_t kind)
+{
+    lock->kind = kind;
+    pthread_mutex_init(&lock->mutex, NULL);
+    atomic_init(&lock->next_ticket, 0);
+    atomic_init(&lock->now_serving, 0);
+    atomic_init(&lock->held, 0);
+    atomic_init(&lock->mcs_tail, NULL);
+    atomic_init(&lock->clh_tail, clh_new_node(0)); // unlocked dummy
+}
+
+void list_lock_destroy(list_lock_t *lock)
+{
+    pthread_mutex_destroy(&lock->mutex);
+    free(atomic_load(&lock->clh_tail));
+}
+
+void list_lock_ctx_init(list_lock_ctx_t *ctx)
+{
+    atomic_init(&ctx->mcs.next, NULL);
+    atomic_init(&ctx->mcs.locked, 0);
+    ctx->clh_node = clh_new_node(0);
+    ctx->clh_pred = NULL;
+}
+
+void list_lock_ctx_destroy(list_lock_ctx_t *ctx)
+{
+    // After a release clh_node is the recycled predecessor, owned by us alone
+    free(ctx->clh_node);
+}
+
+void list_lock_acquire(list_lock_t *lock, list_lock_ctx_t *ctx)
+{
+    int spins = 0;
+
+    switch (lock->kind)
+    {
+    case LOCK_PTHREAD:
+        pthread_mutex_lock(&lock->mutex);
+        break;
+
+    case LOCK_TICKET:
+    {
+        unsigned int ticket = atomic_fetch_add_explicit(&lock->next_ticket, 1, memory_order_relaxed);
+        while (atomic_load_explicit(&lock->now_serving, memory_order_acquire) != ticket)
+            spin_wait(&spins);
+        break;
+    }
+
+    case LOCK_TTAS:
+    {
+        int delay = TTAS_MIN_DELAY;
+        while (1)
+        {
+            while (atomic_load_explicit(&lock->held, memory_order_relaxed))
+                spin_wait(&spins);
+            if (!atomic_exchange_explicit(&lock->held, 1, memory_order_acquire))
+                break;
+            // Lost the race: back off before looking again
+            for (int i = 0; i < delay; i++)
+                cpu_relax();
+            if (delay < TTAS_MAX_DELAY)
+                delay *= 2;
+            else
+                sched_yield();
+        }
+        break;
+    }
+
+    case LOCK_MCS:
+    {
+        struct mcs_node_s *me = &ctx->mcs;
+        atomic_store_explicit(&me->next, NULL, memory_order_relaxed);
+        atomic_store_explicit(&me->locked, 1, memory_order_relaxed);
+        struct mcs_node_s *pred = atomic_exchange_explicit(&lock->mcs_tail, me, memory_order_acq_rel);
+        if (pred != NULL)
+        {
+            atomic_store_explicit(&pred->next, me, memory_order_release);
+            while (atomic_load_explicit(&me->locked, memory_order_acquire))
+                spin_wait(&spins);
+        }
+        break;
+    }
+
+    case LOCK_CLH:
+    {
+        struct clh_node_s *me = ctx->clh_node;
+        atomic_store_explicit(&me->locked, 1, memory_order_relaxed);
+        struct clh_node_s *pred = atomic_exchange_explicit(&lock->clh_tail, me, memory_order_acq_rel);
+        while (atomic_load_explicit(&pred->locked, memory_order_acquire))
+            spin_wait(&spins);
+        ctx->clh_pred = pred;
+        break;
+    }
+
+    default:
+        fprintf(stderr, "Unknown lock kind %d\n", lock->kind);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void list_lock_release(list_lock_t *lock, list_lock_ctx_t *ctx)
+{
+    int spins = 0;
+
+    switch (lock->kind)
+    {
+    case LOCK_PTHREAD:
+        pthread_mutex_unlock(&lock->mutex);
+        break;
+
+    case LOCK_TICKET:
+        atomic_store_explicit(&lock->now_serving,
+                              atomic_load_explicit(&lock->now_serving, memory_order_relaxed) + 1,
+                              memory_order_release);
+        break;
+
+    case LOCK_TTAS:
+        atomic_store_explicit(&lock->held, 0, memory_order_release);
+        break;
+
+    case LOCK_MCS:
+    {
+        struct mcs_node_s *me = &ctx->mcs;
+        struct mcs_node_s *succ = atomic_load_explicit(&me->next, memory_order_acquire);
+        if (succ == NULL)
+        {
+            struct mcs_node_s *expected = me;
+            if (atomic_compare_exchange_strong_explicit(&lock->mcs_tail, &expected, NULL,
+                                                        memory_order_acq_rel, memory_order_acquire))
+                break; // no one waiting
+            // A successor is between its exchange and linking itself in
+            while ((succ = atomic_load_explicit(&me->next, memory_order_acquire)) == NULL)
+                spin_wait(&spins);
+        }
+        atomic_store_explicit(&succ->locked, 0, memory_order_release);
+        break;
+    }
+
+    case LOCK_CLH:
+    {
+        struct clh_node_s *me = ctx->clh_node;
+        atomic_store_explicit(&me->locked, 0, memory_order_release);
+        ctx->clh_node = ctx->clh_pred; // recycle the predecessor's node
+        ctx->clh_pred = NULL;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
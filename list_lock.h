@@ -0,0 +1,68 @@
+#ifndef LIST_LOCK_H
+#define LIST_LOCK_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Small mutual-exclusion abstraction so the mutex build can run on
+// different lock algorithms picked at runtime (--lock=NAME).
+
+#define LIST_LOCK_CACHE_LINE 64
+
+typedef enum
+{
+    LOCK_PTHREAD, // pthread_mutex_t
+    LOCK_TICKET,  // FIFO ticket lock
+    LOCK_TTAS,    // test-and-test-and-set with exponential backoff
+    LOCK_MCS,     // MCS queue lock, each waiter spins on its own node
+    LOCK_CLH,     // CLH queue lock, each waiter spins on its predecessor's node
+    NUM_LOCK_KINDS
+} lock_kind_t;
+
+struct mcs_node_s
+{
+    _Atomic(struct mcs_node_s *) next;
+    atomic_int locked;
+} __attribute__((aligned(LIST_LOCK_CACHE_LINE)));
+
+struct clh_node_s
+{
+    atomic_int locked;
+} __attribute__((aligned(LIST_LOCK_CACHE_LINE)));
+
+typedef struct
+{
+    lock_kind_t kind;
+    pthread_mutex_t mutex;
+    // Ticket lock: the two counters live on separate lines
+    _Alignas(LIST_LOCK_CACHE_LINE) atomic_uint next_ticket;
+    _Alignas(LIST_LOCK_CACHE_LINE) atomic_uint now_serving;
+    // TTAS flag
+    _Alignas(LIST_LOCK_CACHE_LINE) atomic_int held;
+    // Queue tails for MCS and CLH
+    _Alignas(LIST_LOCK_CACHE_LINE) _Atomic(struct mcs_node_s *) mcs_tail;
+    _Alignas(LIST_LOCK_CACHE_LINE) _Atomic(struct clh_node_s *) clh_tail;
+} list_lock_t;
+
+// Per-thread state for the queue locks; one per thread per lock
+typedef struct
+{
+    struct mcs_node_s mcs;
+    struct clh_node_s *clh_node; // node we enqueue next time
+    struct clh_node_s *clh_pred; // predecessor's node while we hold the lock
+} list_lock_ctx_t;
+
+// Lock kind used by the mutex version; set by main.c
+extern lock_kind_t lock_kind;
+
+const char *lock_kind_name(lock_kind_t kind);
+int lock_kind_from_name(const char *name, lock_kind_t *kind);
+
+void list_lock_init(list_lock_t *lock, lock_kind_t kind);
+void list_lock_destroy(list_lock_t *lock);
+void list_lock_ctx_init(list_lock_ctx_t *ctx);
+void list_lock_ctx_destroy(list_lock_ctx_t *ctx);
+void list_lock_acquire(list_lock_t *lock, list_lock_ctx_t *ctx);
+void list_lock_release(list_lock_t *lock, list_lock_ctx_t *ctx);
+
+#endif
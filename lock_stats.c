@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "lock_stats.h"
+
+// Totals over every thread of every run of the current case
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct lock_stats_s case_stats;
+static uint64_t thread_runs = 0;                  // threads merged so far
+static uint64_t min_thread_acquires = UINT64_MAX; // fewest acquisitions by one thread
+static uint64_t max_thread_acquires = 0;
+
+void lock_stats_merge(const struct lock_stats_s *stats)
+{
+    uint64_t acquires = stats->acquires[LOCK_STATS_READ] + stats->acquires[LOCK_STATS_WRITE];
+
+    pthread_mutex_lock(&stats_mutex);
+    for (int mode = 0; mode < 2; mode++)
+    {
+        case_stats.acquires[mode] += stats->acquires[mode];
+        case_stats.wait_ns[mode] += stats->wait_ns[mode];
+        case_stats.hold_ns[mode] += stats->hold_ns[mode];
+    }
+    thread_runs++;
+    if (acquires < min_thread_acquires)
+        min_thread_acquires = acquires;
+    if (acquires > max_thread_acquires)
+        max_thread_acquires = acquires;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+void lock_stats_case_reset(void)
+{
+    memset(&case_stats, 0, sizeof(case_stats));
+    thread_runs = 0;
+    min_thread_acquires = UINT64_MAX;
+    max_thread_acquires = 0;
+}
+
+void lock_stats_print(int thread_count)
+{
+    if (thread_runs == 0)
+        return;
+
+    static const char *mode_names[2] = {"read", "write"};
+    printf("Lock contention (%d threads):\n", thread_count);
+    for (int mode = 0; mode < 2; mode++)
+    {
+        uint64_t acquires = case_stats.acquires[mode];
+        if (acquires == 0)
+            continue;
+        uint64_t wait = case_stats.wait_ns[mode], hold = case_stats.hold_ns[mode];
+        printf("  %-5s %llu acquisitions, avg wait %.0f ns, avg hold %.0f ns, waiting %.1f%% of lock time\n",
+               mode_names[mode], (unsigned long long)acquires, (double)wait / acquires, (double)hold / acquires,
+               wait + hold > 0 ? 100.0 * wait / (wait + hold) : 0.0);
+    }
+    uint64_t total = case_stats.acquires[LOCK_STATS_READ] + case_stats.acquires[LOCK_STATS_WRITE];
+    printf("  acquisitions per thread: avg %.0f, min %llu, max %llu\n", (double)total / thread_runs,
+           (unsigned long long)min_thread_acquires, (unsigned long long)max_thread_acquires);
+}
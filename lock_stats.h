@@ -0,0 +1,63 @@
+#ifndef LOCK_STATS_H
+#define LOCK_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Contention counters around the lock calls of the mutex and rwlock
+// versions: acquisitions, time spent waiting in the acquire call and time
+// the lock was held, split into reader and writer acquisitions. Built
+// only with -DLOCK_STATS (make LOCK_STATS=1); otherwise every macro below
+// expands to nothing and the timed loops are unchanged.
+
+#define LOCK_STATS_READ 0
+#define LOCK_STATS_WRITE 1
+
+struct lock_stats_s
+{
+    uint64_t acquires[2]; // indexed by LOCK_STATS_READ / LOCK_STATS_WRITE
+    uint64_t wait_ns[2];
+    uint64_t hold_ns[2];
+};
+
+// Add one thread's counters to the current case; called once per thread
+// at the end of its run
+void lock_stats_merge(const struct lock_stats_s *stats);
+
+// Clear the case totals, and print them for runs of thread_count threads
+void lock_stats_case_reset(void);
+void lock_stats_print(int thread_count);
+
+#ifdef LOCK_STATS
+static inline uint64_t lock_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// A worker declares its counters once, brackets every acquire with
+// LOCK_STATS_WAIT/LOCK_STATS_ACQUIRED, calls LOCK_STATS_RELEASE right
+// before each release and publishes the counters when it is done
+#define LOCK_STATS_DECLARE(s) \
+    struct lock_stats_s s = {{0}}; \
+    uint64_t s##_wait_start = 0, s##_hold_start = 0
+#define LOCK_STATS_WAIT(s) (s##_wait_start = lock_stats_now())
+#define LOCK_STATS_ACQUIRED(s, mode)                               \
+    do                                                             \
+    {                                                              \
+        s##_hold_start = lock_stats_now();                         \
+        s.acquires[mode]++;                                        \
+        s.wait_ns[mode] += s##_hold_start - s##_wait_start;        \
+    } while (0)
+#define LOCK_STATS_RELEASE(s, mode) (s.hold_ns[mode] += lock_stats_now() - s##_hold_start)
+#define LOCK_STATS_PUBLISH(s) lock_stats_merge(&s)
+#else
+#define LOCK_STATS_DECLARE(s)
+#define LOCK_STATS_WAIT(s) ((void)0)
+#define LOCK_STATS_ACQUIRED(s, mode) ((void)0)
+#define LOCK_STATS_RELEASE(s, mode) ((void)0)
+#define LOCK_STATS_PUBLISH(s) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// Harris-Michael lock-free sorted list. The low bit of a node's next
+// pointer marks the node as logically deleted; unlinked nodes are
+// reclaimed with hazard pointers.
+
+#define HP_PER_THREAD 3     // next, curr, pred
+#define RETIRE_MIN 64 // scan hazard pointers once at least this many nodes are retired
+#define CACHE_LINE 64
+
+struct lf_node_s
+{
+    int data;
+    _Atomic uintptr_t next; // struct lf_node_s * with the mark in bit 0
+};
+
+// One thread's hazard pointers, padded so threads never share a line
+typedef struct
+{
+    _Atomic(struct lf_node_s *) hp[HP_PER_THREAD];
+    char pad[CACHE_LINE - HP_PER_THREAD * sizeof(void *)];
+} hp_record_t;
+
+typedef struct
+{
+    struct lf_node_s *head; // INT_MIN sentinel, never deleted
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    hp_record_t *hazards; // thread_count records
+    int retire_threshold;  // per-thread retired list size, above every hazard pointer
+    atomic_int next_id;
+    struct lf_node_s **leftover; // retired nodes still protected when a thread exits
+    int leftover_count;
+    pthread_mutex_t leftover_mutex;
+} thread_params_t;
+
+// Per-thread view used by the list operations
+typedef struct
+{
+    thread_params_t *params;
+    hp_record_t *my_hp;
+    struct lf_node_s **retired; // retire_threshold entries
+    int retired_count;
+} lf_thread_t;
+
+#define IS_MARKED(p) ((p) & 1)
+#define GET_PTR(p) ((struct lf_node_s *)((p) & ~(uintptr_t)1))
+
+static struct lf_node_s *lf_new_node(int value)
+{
+    struct lf_node_s *node = malloc(sizeof(struct lf_node_s));
+    node->data = value;
+    atomic_init(&node->next, 0);
+    return node;
+}
+
+// Free every retired node that no thread currently protects
+static void lf_scan(lf_thread_t *t)
+{
+    thread_params_t *params = t->params;
+    int kept = 0;
+
+    for (int i = 0; i < t->retired_count; i++)
+    {
+        struct lf_node_s *node = t->retired[i];
+        int hazardous = 0;
+        for (int th = 0; th < params->thread_count && !hazardous; th++)
+            for (int k = 0; k < HP_PER_THREAD; k++)
+                if (atomic_load(&params->hazards[th].hp[k]) == node)
+                {
+                    hazardous = 1;
+                    break;
+                }
+
+        if (hazardous)
+            t->retired[kept++] = node;
+        else
+            free(node);
+    }
+    t->retired_count = kept;
+}
+
+static void lf_retire(lf_thread_t *t, struct lf_node_s *node)
+{
+    // A scan keeps at most HP_PER_THREAD * thread_count nodes, fewer than
+    // the threshold, so the list always has room for the next one
+    t->retired[t->retired_count++] = node;
+    if (t->retired_count >= t->params->retire_threshold)
+        lf_scan(t);
+}
+
+static void lf_clear_hazards(lf_thread_t *t)
+{
+    for (int k = 0; k < HP_PER_THREAD; k++)
+        atomic_store(&t->my_hp->hp[k], NULL);
+}
+
+// Michael's Find: on return *prev_pp is the link that pointed at *curr_pp,
+// curr is the first unmarked node with data >= value (or NULL), and both
+// curr and the node owning prev are protected by hazard pointers.
+// Marked nodes met on the way are unlinked and retired.
+static int lf_find(lf_thread_t *t, int value, _Atomic uintptr_t **prev_pp,
+                   struct lf_node_s **curr_pp, uintptr_t *next_p)
+{
+    _Atomic uintptr_t *prev;
+    struct lf_node_s *curr;
+    uintptr_t next;
+
+try_again:
+    prev = &t->params->head->next;
+    curr = GET_PTR(atomic_load(prev));
+
+    while (1)
+    {
+        if (curr == NULL)
+        {
+            *prev_pp = prev;
+            *curr_pp = NULL;
+            *next_p = 0;
+            return 0;
+        }
+
+        // Protect curr, then make sure it is still linked from prev
+        atomic_store(&t->my_hp->hp[1], curr);
+        if (atomic_load(prev) != (uintptr_t)curr)
+            goto try_again;
+
+        next = atomic_load(&curr->next);
+        atomic_store(&t->my_hp->hp[0], GET_PTR(next));
+        if (atomic_load(&curr->next) != next)
+            goto try_again;
+
+        int data = curr->data;
+        if (atomic_load(prev) != (uintptr_t)curr)
+            goto try_again;
+
+        if (!IS_MARKED(next))
+        {
+            if (data >= value)
+            {
+                *prev_pp = prev;
+                *curr_pp = curr;
+                *next_p = next;
+                return data == value;
+            }
+            prev = &curr->next;
+            atomic_store(&t->my_hp->hp[2], curr);
+        }
+        else
+        {
+            // curr is logically deleted, help unlink it
+            uintptr_t expected = (uintptr_t)curr;
+            if (atomic_compare_exchange_strong(prev, &expected, (uintptr_t)GET_PTR(next)))
+                lf_retire(t, curr);
+            else
+                goto try_again;
+        }
+        curr = GET_PTR(next);
+    }
+}
+
+static int lf_member(lf_thread_t *t, int value)
+{
+    _Atomic uintptr_t *prev;
+    struct lf_node_s *curr;
+    uintptr_t next;
+
+    int found = lf_find(t, value, &prev, &curr, &next);
+    lf_clear_hazards(t);
+    return found;
+}
+
+static int lf_insert(lf_thread_t *t, int value)
+{
+    _Atomic uintptr_t *prev;
+    struct lf_node_s *curr;
+    uintptr_t next;
+    struct lf_node_s *temp_p = NULL;
+
+    while (1)
+    {
+        if (lf_find(t, value, &prev, &curr, &next))
+        {
+            free(temp_p); // never published
+            lf_clear_hazards(t);
+            return 0;
+        }
+
+        if (temp_p == NULL)
+            temp_p = lf_new_node(value);
+        atomic_store_explicit(&temp_p->next, (uintptr_t)curr, memory_order_relaxed);
+
+        uintptr_t expected = (uintptr_t)curr;
+        if (atomic_compare_exchange_strong(prev, &expected, (uintptr_t)temp_p))
+        {
+            lf_clear_hazards(t);
+            return 1;
+        }
+    }
+}
+
+static int lf_delete(lf_thread_t *t, int value)
+{
+    _Atomic uintptr_t *prev;
+    struct lf_node_s *curr;
+    uintptr_t next;
+
+    while (1)
+    {
+        if (!lf_find(t, value, &prev, &curr, &next))
+        {
+            lf_clear_hazards(t);
+            return 0;
+        }
+
+        // Logical delete: mark curr's next pointer
+        uintptr_t expected = next;
+        if (!atomic_compare_exchange_strong(&curr->next, &expected, next | 1))
+            continue;
+
+        // Physical delete; if it fails another Find will unlink it
+        expected = (uintptr_t)curr;
+        if (atomic_compare_exchange_strong(prev, &expected, next))
+            lf_retire(t, curr);
+        else
+            lf_find(t, value, &prev, &curr, &next);
+
+        lf_clear_hazards(t);
+        return 1;
+    }
+}
+
+// Copy the (already sorted) initial list behind the sentinel
+static struct lf_node_s *lf_build(struct list_node_s *head_p)
+{
+    struct lf_node_s *head = lf_new_node(INT_MIN);
+    struct lf_node_s *tail = head;
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        struct lf_node_s *node = lf_new_node(curr_p->data);
+        atomic_store_explicit(&tail->next, (uintptr_t)node, memory_order_relaxed);
+        tail = node;
+    }
+    return head;
+}
+
+static void lf_destroy(struct lf_node_s *head)
+{
+    struct lf_node_s *curr_p = head;
+    while (curr_p != NULL)
+    {
+        struct lf_node_s *next = GET_PTR(atomic_load_explicit(&curr_p->next, memory_order_relaxed));
+        free(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    lf_thread_t self;
+    self.params = params;
+    self.my_hp = &params->hazards[atomic_fetch_add(&params->next_id, 1)];
+    self.retired = malloc(params->retire_threshold * sizeof(struct lf_node_s *));
+    self.retired_count = 0;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations without any locks
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            lf_insert(&self, val);
+        else if (op == 1)
+            lf_delete(&self, val);
+        else
+            lf_member(&self, val);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    // Reclaim what we can; anything still protected is freed after the join
+    lf_scan(&self);
+    pthread_mutex_lock(&params->leftover_mutex);
+    for (int i = 0; i < self.retired_count; i++)
+        params->leftover[params->leftover_count++] = self.retired[i];
+    pthread_mutex_unlock(&params->leftover_mutex);
+    free(self.retired);
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_lockfree(struct list_node_s **list_head,
+                            int m,
+                            double mMember,
+                            double mInsert,
+                            double mDelete,
+                            int thread_count,
+                            int program_type)
+{
+    if (program_type != 5) // 5 = lock-free list version
+    {
+        fprintf(stderr, "Only lock-free list version (program_type=5) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    // Convert the initial list outside the timed region
+    struct lf_node_s *head = lf_build(*list_head);
+
+    thread_params_t params = {head, m, mMember, mInsert, mDelete, thread_count};
+    params.hazards = aligned_alloc(CACHE_LINE, thread_count * sizeof(hp_record_t));
+    for (int th = 0; th < thread_count; th++)
+        for (int k = 0; k < HP_PER_THREAD; k++)
+            atomic_init(&params.hazards[th].hp[k], NULL);
+    atomic_init(&params.next_id, 0);
+    params.retire_threshold = 2 * HP_PER_THREAD * thread_count;
+    if (params.retire_threshold < RETIRE_MIN)
+        params.retire_threshold = RETIRE_MIN;
+    params.leftover = malloc(thread_count * params.retire_threshold * sizeof(struct lf_node_s *));
+    params.leftover_count = 0;
+    pthread_mutex_init(&params.leftover_mutex, NULL);
+
+    printf("Running in lock-free list mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // All hazard pointers are clear now
+    for (int i = 0; i < params.leftover_count; i++)
+        free(params.leftover[i]);
+
+    // Free both lists
+    lf_destroy(head);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+    pthread_mutex_destroy(&params.leftover_mutex);
+    free(params.leftover);
+    free(params.hazards);
+
+    return elapsed_time;
+}
@@ -1,21 +1,96 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
 #include <stdbool.h>
 #include <limits.h>
 #include <math.h>
+#include <unistd.h>
 #include "linkedlist.h"
 #include "run_threads.h"
+#include "node_pool.h"
+#include "list_lock.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "key_dist.h"
+#include "latency.h"
+#include "lock_stats.h"
+#include "perf_counters.h"
+#include "affinity.h"
+#include "duration.h"
+#include "bench_stats.h"
+#include "build_id.h" // BUILD_ID: git revision, compiler and flags, written by the makefile
 
 #define MAX_VALUE 65536 // 2^16
 
+// program_type is a backend's position in list_backends (backends.c)
+#define PROGRAM_TYPE_LOCKFREE 5
+#define PROGRAM_TYPE_SHARDED 8
+#define PROGRAM_TYPE_MUTEX 1
+#define PROGRAM_TYPE_RWLOCK 2
+#define PROGRAM_TYPE_DIST_RWLOCK 10
+#define PROGRAM_TYPE_HASH 13
+
+#define NUM_CASES 3       // built-in operation mixes, see get_case_ops
+#define BASE_SWEEP_MAX 8  // every parallel version runs at 1, 2, 4 and 8 threads
+#define MAX_SWEEP 64      // room for the per-backend thread-count sweeps
+
+// Bumped whenever the CSV columns change; results go to files named after
+// it, so rows of different layouts never end up in the same file
+#define CSV_SCHEMA 2
+#define CSV_HEADER "ProgramType,Case,Average(us),StdDev(us),Min(us),Max(us),95% CI Lower(us),95% CI Upper(us),Thread Count,Lock Type,Fairness,StartSkew(us)," \
+                   "n,m,KeyRange,Member,Insert,Delete,Distribution," \
+                   "MemberP50(ns),MemberP99(ns),MemberP99.9(ns),MemberMax(ns),InsertP50(ns),InsertP99(ns),InsertP99.9(ns),InsertMax(ns)," \
+                   "DeleteP50(ns),DeleteP99(ns),DeleteP99.9(ns),DeleteMax(ns)," \
+                   "Cycles/Op,Instructions/Op,IPC,L1DMisses/Op,LLCMisses/Op,BranchMisses/Op,CtxSwitches/Run,Affinity," \
+                   "Duration(s),Ops/Run,Throughput(ops/s),Median(us),Runs,Outliers,Speedup,Efficiency,Build,ListBuild(us)"
+
 int n = 1000;  // initial population size
 int m = 10000; // number of operations
+int key_range = MAX_VALUE; // keys are drawn from [0, key_range)
+int shard_count = 16;      // key-range shards for the sharded version
+double run_fairness = 0;   // set by run_threads when the version measures it
+int batch_size = 1;        // operations applied per lock acquisition
+
+static int num_cases = NUM_CASES;  // 1 when --mix replaces the built-in mixes
+static double custom_mix[3];       // Member, Insert and Delete fractions from --mix
+static char dist_label[32] = "uniform"; // key distribution, as recorded in the CSV
+
+// Adaptive run driver: every case first runs warmup_runs unrecorded runs,
+// then at least min_runs and at most max_runs recorded ones, stopping as
+// soon as the 95% CI half-width is within ci_target of the mean
+static int warmup_runs = 2;
+static int min_runs = 10;
+static int max_runs = 30;
+static double ci_target = 0.05;
+
+static double serial_throughput[NUM_CASES + 1]; // serial baseline per case in ops/s, 0 until measured
+static int build_threads = 1;      // threads filling the initial list (--build-threads)
+static double run_build_us = 0;    // initial list build time of the last run
+static FILE *json_fp = NULL;                // --json: one line per sweep
+static int json_points = 0;                 // points written to the current sweep
 
 // Main test function
 void get_case_ops(int case_num, double *mmem, double *mins, double *mdel)
 {
+    // A trace carries the mixes it was generated with
+    double mix[3];
+    if (trace_loaded && op_trace_case_mix(case_num, mix))
+    {
+        *mmem = mix[0];
+        *mins = mix[1];
+        *mdel = mix[2];
+        return;
+    }
+    if (num_cases == 1)
+    {
+        *mmem = custom_mix[0];
+        *mins = custom_mix[1];
+        *mdel = custom_mix[2];
+        return;
+    }
+
     // Set operation fractions based on case
     switch (case_num)
     {
@@ -50,147 +125,776 @@ void get_case_ops(int case_num, double *mmem, double *mins, double *mdel)
     }
 }
 
+// Pick exactly n unique random values with a bitmap and store them in
+// ascending order, in O(key_range) instead of n sorted inserts (which is
+// O(n^2) and too slow for large n)
+static void pick_initial_keys(int *keys)
+{
+    unsigned char *chosen = calloc(key_range, 1);
+    int count = 0;
+    while (count < n)
+    {
+        int val = rand() % key_range;
+        if (!chosen[val])
+        { // Only count unique values
+            chosen[val] = 1;
+            count++;
+        }
+    }
+    count = 0;
+    for (int val = 0; val < key_range; val++)
+    {
+        if (chosen[val])
+            keys[count++] = val;
+    }
+    free(chosen);
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
 unsigned long run_experiment(int case_num, int thread_count, int program_type)
 {
     double mmem, mins, mdel;
     get_case_ops(case_num, &mmem, &mins, &mdel);
 
-    struct list_node_s *head = NULL;
-
-    // Populate list with exactly n unique random values
-    int count = 0;
-    while (count < n)
+    // Build the sorted initial list in one pass; timed apart from the run
+    double build_start = now_us();
+    int *keys = malloc(n * sizeof(int));
+    if (trace_loaded)
     {
-        int val = rand() % MAX_VALUE;
-        if (Insert(val, &head))
-        { // Only count successful inserts
-            count++;
+        // Initial keys and operations both come from the trace
+        if (!op_trace_select(case_num, thread_count))
+        {
+            fprintf(stderr, "Trace has no operations for case %d with %d threads.\n", case_num, thread_count);
+            exit(EXIT_FAILURE);
         }
+        const uint32_t *trace_keys = op_trace_initial_keys();
+        for (int i = 0; i < n; i++)
+            keys[i] = trace_keys[i];
     }
+    else
+        pick_initial_keys(keys);
+    struct list_node_s *head = BuildList(keys, n, build_threads);
+    free(keys);
+    run_build_us = now_us() - build_start;
 
-    unsigned long elapsed = run_threads(&head, m, mmem, mins, mdel, thread_count, program_type);
+    latency_run_begin(thread_count);
+    perf_run_begin(thread_count);
+    duration_run_begin(thread_count);
+    unsigned long elapsed = list_backends[program_type].run_threads(&head, m, mmem, mins, mdel, thread_count, program_type);
+    duration_run_end(elapsed);
+    perf_run_end();
+    latency_run_end();
 
     return elapsed;
 }
 
-void write_to_csv(FILE *fp, int num_runs, unsigned long times[], int thread_count, int program_type)
+// Name of a backend in CSV rows and JSON, with the options that change its results
+static void backend_label(int program_type, char *buf, size_t len)
 {
-    for (int case_num = 1; case_num <= 3; case_num++)
+    snprintf(buf, len, "%s", list_backends[program_type].label);
+    if (program_type == PROGRAM_TYPE_SHARDED) // rows of an S sweep must stay apart
+        snprintf(buf, len, "%s-S%d", list_backends[program_type].label, shard_count);
+    if (batch_size > 1 && (program_type == PROGRAM_TYPE_MUTEX || program_type == PROGRAM_TYPE_RWLOCK ||
+                           program_type == PROGRAM_TYPE_DIST_RWLOCK))
     {
-        printf("\n--- Case %d ---\n", case_num);
+        size_t used = strlen(buf);
+        snprintf(buf + used, len - used, "-B%d", batch_size);
+    }
+    if (use_node_pool)
+    {
+        size_t used = strlen(buf);
+        snprintf(buf + used, len - used, "+Pool");
+    }
+}
 
-        unsigned long total_time = 0, min_time = ULONG_MAX, max_time = 0;
+void write_to_csv(FILE *fp, unsigned long times[], int thread_count, int program_type)
+{
+    for (int case_num = 1; case_num <= num_cases; case_num++)
+    {
+        printf("\n--- Case %d ---\n", case_num);
+        double mmem, mins, mdel;
+        get_case_ops(case_num, &mmem, &mins, &mdel);
+        latency_case_reset();
+        perf_case_reset();
+        duration_case_reset();
+#ifdef LOCK_STATS
+        lock_stats_case_reset();
+#endif
 
-        for (int run = 0; run < num_runs; run++)
+        // Warmup runs settle caches, the allocator and the pool; their
+        // results are discarded
+        for (int run = 0; run < warmup_runs; run++)
         {
-            printf("Run %d/%d: ", run + 1, num_runs);
-            times[run] = run_experiment(case_num, thread_count, program_type);
-            total_time += times[run];
-
-            if (times[run] < min_time)
-                min_time = times[run];
-            if (times[run] > max_time)
-                max_time = times[run];
+            printf("Warmup %d/%d: ", run + 1, warmup_runs);
+            run_experiment(case_num, thread_count, program_type);
         }
+        latency_case_reset();
+        perf_case_reset();
+        duration_case_reset();
+#ifdef LOCK_STATS
+        lock_stats_case_reset();
+#endif
 
-        double avg_time = (double)total_time / num_runs;
+        double total_fairness = 0, total_skew = 0, total_build = 0;
+        struct run_stats_s stats;
+        int num_runs = 0, ci_met = 0;
+        while (num_runs < max_runs && !ci_met)
+        {
+            printf("Run %d/%d: ", num_runs + 1, max_runs);
+            run_fairness = 0;
+            pool_start_skew = 0;
+            times[num_runs++] = run_experiment(case_num, thread_count, program_type);
+            total_fairness += run_fairness;
+            total_skew += pool_start_skew;
+            total_build += run_build_us;
 
-        double variance = 0;
-        for (int i = 0; i < num_runs; i++)
-            variance += (times[i] - avg_time) * (times[i] - avg_time);
-        variance /= num_runs;
-        double std_dev = sqrt(variance);
-        double margin_error = 1.96 * std_dev / sqrt(num_runs);
+            run_stats_compute(times, num_runs, &stats);
+            ci_met = num_runs >= min_runs && stats.ci_half <= ci_target * stats.mean;
+        }
+        double avg_time = stats.mean, std_dev = stats.std_dev, margin_error = stats.ci_half;
+        unsigned long min_time = stats.min, max_time = stats.max;
 
         printf("\nCase %d Results:\n", case_num);
-        printf("Average time: %.2f us, StdDev: %.2f us, Min: %lu us, Max: %lu us\n",
-               avg_time, std_dev, min_time, max_time);
+        printf("Runs: %d (+%d warmup), outliers rejected: %d, CI target %s\n", num_runs, warmup_runs,
+               stats.outliers, ci_met ? "met" : "not met");
+        printf("Average time: %.2f us, Median: %.2f us, StdDev: %.2f us, Min: %lu us, Max: %lu us\n",
+               avg_time, stats.median, std_dev, min_time, max_time);
         printf("95%% CI: %.2f ± %.2f us\n", avg_time, margin_error);
         printf("Range: [%.2f, %.2f] us\n", avg_time - margin_error, avg_time + margin_error);
 
-        double required_accuracy = 0.05 * avg_time; // 5% of mean
-        int required_samples = (int)ceil(pow((1.96 * std_dev) / required_accuracy, 2));
+        // With --duration the operation count varies and the time is fixed
+        double ops_per_run = run_duration > 0 ? duration_case_ops_per_run() : m;
+        double throughput = avg_time > 0 ? ops_per_run / avg_time * 1e6 : 0.0;
+        printf("Throughput: %.0f ops/s\n", throughput);
 
-        printf("Required samples for 95%% CI within 5%%: %d\n", required_samples);
+        // Scaling against the serial version's median throughput for the same
+        // case; with a fixed operation count this is the ratio of median times
+        double median_throughput = stats.median > 0 ? ops_per_run / stats.median * 1e6 : 0.0;
+        if (program_type == 0)
+            serial_throughput[case_num] = median_throughput;
+        double speedup = serial_throughput[case_num] > 0 ? median_throughput / serial_throughput[case_num] : 0;
+        double efficiency = speedup / thread_count;
+        if (speedup > 0 && program_type != 0)
+            printf("Speedup vs serial: %.2fx, efficiency: %.2f\n", speedup, efficiency);
+        duration_case_print(thread_count);
 
-        const char *program_type_str = NULL;
+        double avg_fairness = total_fairness / num_runs;
+        if (avg_fairness > 0)
+            printf("Per-thread fairness (Jain's index): %.4f\n", avg_fairness);
 
-        if (program_type == 0)
-            program_type_str = "Serial";
-        else if (program_type == 1)
-            program_type_str = "Mutex";
-        else if (program_type == 2)
-            program_type_str = "RWLock";
-        else
-            program_type_str = "Unknown";
-
-        // Write to CSV
-        fprintf(fp, "%s,%d,%.2f,%.2f,%lu,%lu,%.2f,%.2f,%d\n",
-                program_type_str, case_num, avg_time, std_dev, min_time, max_time, avg_time - margin_error, avg_time + margin_error, thread_count);
+        // Thread wake-up spread, excluded from the times above
+        double avg_skew = total_skew / num_runs;
+        if (thread_count > 1)
+            printf("Startup skew: %.2f us\n", avg_skew);
+
+        // Key selection and list construction, not part of the times above
+        double avg_build = total_build / num_runs;
+        printf("Initial list build: %.2f us (%d keys, %d build thread%s)\n", avg_build, n, build_threads,
+               build_threads == 1 ? "" : "s");
+
+        // Cycles, misses etc. per operation, for the whole run and per thread
+        perf_case_print(thread_count, ops_per_run);
+        char perf_cols[128];
+        perf_case_csv(perf_cols, sizeof(perf_cols), thread_count, ops_per_run);
+
+#ifdef LOCK_STATS
+        // Waiting vs. holding for the versions with instrumented locks
+        lock_stats_print(thread_count);
+#endif
+
+        size_t affinity_len = affinity_describe_size(thread_count);
+        char *affinity_col = malloc(affinity_len);
+        affinity_describe(thread_count, affinity_col, affinity_len);
+
+        // Per-op tails over every run of the case, in CSV order Member, Insert, Delete
+        static const int latency_ops[3] = {LIST_OP_MEMBER, LIST_OP_INSERT, LIST_OP_DELETE};
+        static const char *latency_names[3] = {"Member", "Insert", "Delete"};
+        char latency_cols[256] = "";
+        for (int i = 0; i < 3; i++)
+        {
+            int op = latency_ops[i];
+            uint64_t p50 = latency_percentile(op, 0.50), p99 = latency_percentile(op, 0.99);
+            uint64_t p999 = latency_percentile(op, 0.999), max = latency_max(op);
+            size_t len = strlen(latency_cols);
+            if (!measure_latency)
+                snprintf(latency_cols + len, sizeof(latency_cols) - len, ",-,-,-,-");
+            else
+                snprintf(latency_cols + len, sizeof(latency_cols) - len, ",%llu,%llu,%llu,%llu",
+                         (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)p999, (unsigned long long)max);
+            if (measure_latency && max > 0)
+                printf("%s latency: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n", latency_names[i],
+                       (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)p999, (unsigned long long)max);
+        }
+
+        // Only the mutex version has a pluggable lock
+        const char *lock_type_str = program_type == PROGRAM_TYPE_MUTEX ? lock_kind_name(lock_kind) : "-";
+
+        // Jain's index is at least 1/threads, so 0 means no run measured it
+        char fairness_col[32] = "-", fairness_json[32] = "null";
+        if (avg_fairness > 0)
+        {
+            snprintf(fairness_col, sizeof(fairness_col), "%.4f", avg_fairness);
+            snprintf(fairness_json, sizeof(fairness_json), "%.4f", avg_fairness);
+        }
+
+        char program_type_str[64];
+        backend_label(program_type, program_type_str, sizeof(program_type_str));
+
+        // Write to CSV, with the workload parameters so rows are self-describing
+        char speedup_cols[64] = ",-,-";
+        if (speedup > 0)
+            snprintf(speedup_cols, sizeof(speedup_cols), ",%.3f,%.3f", speedup, efficiency);
+        fprintf(fp, "%s,%d,%.2f,%.2f,%lu,%lu,%.2f,%.2f,%d,%s,%s,%.2f,%d,%d,%d,%.4f,%.4f,%.4f,%s%s%s,%s,%g,%.0f,%.0f,%.2f,%d,%d%s,%s,%.2f\n",
+                program_type_str, case_num, avg_time, std_dev, min_time, max_time, avg_time - margin_error, avg_time + margin_error, thread_count,
+                lock_type_str, fairness_col, avg_skew, n, m, key_range, mmem, mins, mdel, dist_label, latency_cols, perf_cols, affinity_col,
+                run_duration, ops_per_run, throughput, stats.median, num_runs, stats.outliers, speedup_cols, BUILD_ID, avg_build);
+        free(affinity_col);
+
+        if (json_fp != NULL)
+        {
+            fprintf(json_fp, "%s{\"case\":%d,\"threads\":%d,\"mix\":[%.4f,%.4f,%.4f],\"runs\":%d,\"outliers\":%d,"
+                             "\"ci_met\":%s,\"median_us\":%.2f,\"mean_us\":%.2f,\"stddev_us\":%.2f,\"ci95_us\":[%.2f,%.2f],"
+                             "\"min_us\":%lu,\"max_us\":%lu,\"ops_per_run\":%.0f,\"throughput_ops_s\":%.0f,\"fairness\":%s,\"list_build_us\":%.2f,",
+                    json_points++ > 0 ? "," : "", case_num, thread_count, mmem, mins, mdel, num_runs, stats.outliers,
+                    ci_met ? "true" : "false", stats.median, avg_time, std_dev, avg_time - margin_error, avg_time + margin_error,
+                    min_time, max_time, ops_per_run, throughput, fairness_json, avg_build);
+            if (speedup > 0)
+                fprintf(json_fp, "\"speedup\":%.3f,\"efficiency\":%.3f}", speedup, efficiency);
+            else
+                fprintf(json_fp, "\"speedup\":null,\"efficiency\":null}");
+        }
     }
 }
 
+// Thread counts a backend is measured at; returns how many
+static int sweep_thread_counts(int program_type, int counts[MAX_SWEEP])
+{
+    int num = 0;
+    if (program_type == 0)
+    {
+        counts[num++] = 1;
+        return num;
+    }
+
+    // All parallel versions sweep the same thread counts
+    for (int threads = 1; threads <= BASE_SWEEP_MAX; threads *= 2)
+        counts[num++] = threads;
+
+    // Reader-writer locks also sweep up to every online core, to show
+    // whether reader-side scaling holds beyond 8 threads; so does the
+    // hash set, whose stripes should keep scaling
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (program_type == PROGRAM_TYPE_RWLOCK || program_type == PROGRAM_TYPE_DIST_RWLOCK ||
+        program_type == PROGRAM_TYPE_HASH)
+    {
+        for (long threads = 2 * BASE_SWEEP_MAX; threads < cores && num < MAX_SWEEP - 1; threads *= 2)
+            counts[num++] = (int)threads;
+        if (cores > BASE_SWEEP_MAX && num < MAX_SWEEP)
+            counts[num++] = (int)cores;
+    }
+
+    // Non-blocking versions should keep scaling when threads outnumber
+    // cores; threads == cores is the point to compare them against
+    if (program_type == PROGRAM_TYPE_LOCKFREE)
+    {
+        for (int factor = 1; factor <= 4; factor *= 2)
+        {
+            if (cores * factor > BASE_SWEEP_MAX && num < MAX_SWEEP)
+                counts[num++] = (int)(cores * factor);
+        }
+    }
+    return num;
+}
+
 // Function to run multiple tests and calculate statistics
 void run_performance_tests(int program_type, FILE *fp)
 {
-    const int num_runs = 30;
-    unsigned long times[num_runs];
-    int thread_counts[] = {1, 2, 4, 8};
+    unsigned long *times = malloc(max_runs * sizeof(unsigned long));
+    int thread_counts[MAX_SWEEP];
+    int num_counts = sweep_thread_counts(program_type, thread_counts);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
 
     printf("\n=== PERFORMANCE TESTING ===\n");
-    if (program_type == 0)
+
+    // One JSON line per sweep: the backend, the workload, the build and every point
+    if (json_fp != NULL)
     {
-        write_to_csv(fp, num_runs, times, 1, 0);
+        char label[64];
+        backend_label(program_type, label, sizeof(label));
+        fprintf(json_fp, "{\"impl\":\"%s\",\"label\":\"%s\",\"build\":\"%s\",\"n\":%d,\"m\":%d,\"key_range\":%d,"
+                         "\"distribution\":\"%s\",\"duration_s\":%g,\"lock\":\"%s\",\"affinity\":\"%s\","
+                         "\"warmup_runs\":%d,\"min_runs\":%d,\"max_runs\":%d,\"ci_target\":%g,"
+                         "\"outlier_rule\":\"tukey_1.5_iqr\",\"points\":[",
+                list_backends[program_type].name, label, BUILD_ID, n, m, key_range, dist_label, run_duration,
+                program_type == PROGRAM_TYPE_MUTEX ? lock_kind_name(lock_kind) : "-",
+                affinity_policy_name(affinity_policy), warmup_runs, min_runs, max_runs, ci_target);
+        json_points = 0;
     }
-    else if (program_type == 1)
-    {
 
-        for (int i = 0; i <= 3; i++)
+    // Worker threads are created once and reused by every run below
+    if (program_type != 0)
+        thread_pool_start(thread_counts[num_counts - 1]);
+
+    for (int i = 0; i < num_counts; i++)
+    {
+        if (thread_counts[i] > cores)
+            printf("\nOversubscription: %d threads on %ld online cores\n", thread_counts[i], cores);
+        if (affinity_policy != AFFINITY_NONE)
         {
-            write_to_csv(fp, num_runs, times, thread_counts[i], 1);
+            size_t mapping_len = affinity_describe_size(thread_counts[i]);
+            char *mapping = malloc(mapping_len);
+            affinity_describe(thread_counts[i], mapping, mapping_len);
+            printf("\nThread -> CPU mapping (%s)\n", mapping);
+            free(mapping);
         }
+        write_to_csv(fp, times, thread_counts[i], program_type);
     }
-    else if (program_type == 2)
+
+    if (json_fp != NULL)
     {
-        for (int i = 0; i <= 3; i++)
+        fprintf(json_fp, "]}\n");
+        fflush(json_fp);
+    }
+    free(times);
+
+    if (program_type != 0)
+        thread_pool_stop();
+
+    printf("\nResults saved to performance_results_v%d CSV files\n", CSV_SCHEMA);
+}
+
+// Every thread count any backend is measured at, so one trace serves all
+static int all_thread_counts(int counts[MAX_SWEEP])
+{
+    int num = 0;
+    for (int b = 0; b < num_list_backends; b++)
+    {
+        int sweep[MAX_SWEEP];
+        int num_sweep = sweep_thread_counts(b, sweep);
+        for (int i = 0; i < num_sweep; i++)
         {
-            write_to_csv(fp, num_runs, times, thread_counts[i], 2);
+            int seen = 0;
+            for (int j = 0; j < num && !seen; j++)
+                seen = counts[j] == sweep[i];
+            if (!seen && num < MAX_SWEEP)
+                counts[num++] = sweep[i];
         }
     }
+    return num;
+}
+
+// Write the initial keys and every case's operations for every thread
+// count to path, with the current n, m and key range
+static int generate_trace(const char *path)
+{
+    double mixes[NUM_CASES][3];
+    for (int c = 0; c < num_cases; c++)
+        get_case_ops(c + 1, &mixes[c][0], &mixes[c][1], &mixes[c][2]);
+
+    int thread_counts[MAX_SWEEP];
+    int num_counts = all_thread_counts(thread_counts);
+
+    int *keys = malloc(n * sizeof(int));
+    pick_initial_keys(keys);
+    int result = op_trace_write(path, keys, n, key_range, m, mixes, num_cases, thread_counts, num_counts);
+    free(keys);
+
+    if (result == 0)
+        printf("Wrote trace %s: n = %d, m = %d, key range = [0, %d), keys %s, %d cases x %d thread counts\n",
+               path, n, m, key_range, dist_label, num_cases, num_counts);
+    return result;
+}
+
+// Parse "--mix=MEM,INS,DEL" percentages into custom_mix; returns 1 on success
+static int parse_mix(const char *spec)
+{
+    double pct[3];
+    char *end;
+    for (int i = 0; i < 3; i++)
+    {
+        pct[i] = strtod(spec, &end);
+        if (end == spec || pct[i] < 0 || *end != (i < 2 ? ',' : '\0'))
+            return 0;
+        spec = end + 1;
+    }
+    if (fabs(pct[0] + pct[1] + pct[2] - 100) > 1e-6)
+        return 0;
+    for (int i = 0; i < 3; i++)
+        custom_mix[i] = pct[i] / 100;
+    return 1;
+}
 
-    printf("\nResults saved to performance_results.csv files\n");
+// Parse a comma-separated list of backend names ("all" selects every
+// backend) into program types; returns how many, or -1 on a bad name
+static int parse_impl_list(char *list, int selected[])
+{
+    int count = 0;
+    for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ","))
+    {
+        if (strcmp(name, "all") == 0)
+        {
+            for (int i = 0; i < num_list_backends && count < num_list_backends; i++)
+                selected[count++] = i;
+            continue;
+        }
+
+        int program_type = find_backend(name);
+        if (program_type < 0)
+        {
+            printf("Unknown implementation %s\n", name);
+            return -1;
+        }
+        if (count < num_list_backends)
+            selected[count++] = program_type;
+    }
+    return count;
 }
 
 int main(int argc, char *argv[])
 {
-    if (argc < 2)
+    // Backends to benchmark, from --impl= or the program_type argument
+    int selected[num_list_backends];
+    int num_selected = 0;
+    const char *gen_trace_path = NULL; // write a trace and exit
+    const char *trace_path = NULL;     // replay a trace
+    const char *json_path = NULL;      // append one JSON line per sweep
+    int range_given = 0;               // --range= fixes the key range
+    int workload_given = 0;            // any of --n, --m, --range, --mix, --dist
+
+    // Split "--" options from the positional arguments
+    char *args[3] = {argv[0], NULL, NULL};
+    int nargs = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--impl=", 7) == 0)
+        {
+            num_selected = parse_impl_list(argv[i] + 7, selected);
+            if (num_selected < 0)
+                return 1;
+        }
+        else if (strncmp(argv[i], "--gen-trace=", 12) == 0)
+            gen_trace_path = argv[i] + 12;
+        else if (strncmp(argv[i], "--trace=", 8) == 0)
+            trace_path = argv[i] + 8;
+        else if (strncmp(argv[i], "--n=", 4) == 0)
+        {
+            n = atoi(argv[i] + 4);
+            workload_given = 1;
+            if (n <= 0)
+            {
+                printf("Invalid initial size. Must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--m=", 4) == 0)
+        {
+            m = atoi(argv[i] + 4);
+            workload_given = 1;
+            if (m <= 0)
+            {
+                printf("Invalid number of operations. Must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--range=", 8) == 0)
+        {
+            key_range = atoi(argv[i] + 8);
+            range_given = workload_given = 1;
+            if (key_range <= 0 || key_range > TRACE_MAX_KEY_RANGE)
+            {
+                printf("Invalid key range. Must be between 1 and %d.\n", TRACE_MAX_KEY_RANGE);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--mix=", 6) == 0)
+        {
+            workload_given = 1;
+            if (!parse_mix(argv[i] + 6))
+            {
+                printf("Invalid mix %s. Must be MEMBER,INSERT,DELETE percentages adding up to 100.\n", argv[i] + 6);
+                return 1;
+            }
+            num_cases = 1;
+        }
+        else if (strncmp(argv[i], "--dist=", 7) == 0)
+        {
+            workload_given = 1;
+            if (!key_dist_parse(argv[i] + 7, &key_dist))
+            {
+                printf("Invalid distribution %s. Must be uniform, zipf[:THETA], hotspot[:KEYS:OPS], asc or desc.\n", argv[i] + 7);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--latency") == 0)
+            measure_latency = 1;
+        else if (strcmp(argv[i], "--perf") == 0)
+            measure_perf = 1;
+        else if (strncmp(argv[i], "--affinity=", 11) == 0)
+        {
+            if (!affinity_policy_from_name(argv[i] + 11, &affinity_policy))
+            {
+                printf("Invalid affinity policy %s. Must be none, compact or scatter.\n", argv[i] + 11);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--duration=", 11) == 0)
+        {
+            run_duration = atof(argv[i] + 11);
+            if (run_duration <= 0)
+            {
+                printf("Invalid duration. Must be a positive number of seconds.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--interval=", 11) == 0)
+        {
+            sample_interval = atof(argv[i] + 11);
+            if (sample_interval <= 0)
+            {
+                printf("Invalid sample interval. Must be a positive number of seconds.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--warmup=", 9) == 0)
+        {
+            warmup_runs = atoi(argv[i] + 9);
+            if (warmup_runs < 0)
+            {
+                printf("Invalid warmup count. Must not be negative.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--runs=", 7) == 0)
+            min_runs = max_runs = atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "--min-runs=", 11) == 0)
+            min_runs = atoi(argv[i] + 11);
+        else if (strncmp(argv[i], "--max-runs=", 11) == 0)
+            max_runs = atoi(argv[i] + 11);
+        else if (strncmp(argv[i], "--ci=", 5) == 0)
+        {
+            ci_target = atof(argv[i] + 5) / 100;
+            if (ci_target <= 0)
+            {
+                printf("Invalid CI target. Must be a positive percentage of the mean.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--build-threads=", 16) == 0)
+        {
+            build_threads = atoi(argv[i] + 16);
+            if (build_threads < 1)
+            {
+                printf("Invalid build thread count. Must be at least 1.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--json=", 7) == 0)
+            json_path = argv[i] + 7;
+        else if (strcmp(argv[i], "--pool") == 0)
+            use_node_pool = 1;
+        else if (strncmp(argv[i], "--shards=", 9) == 0)
+        {
+            shard_count = atoi(argv[i] + 9);
+            if (shard_count <= 0)
+            {
+                printf("Invalid shard count. Must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--lock=", 7) == 0)
+        {
+            if (!lock_kind_from_name(argv[i] + 7, &lock_kind))
+            {
+                printf("Invalid lock type %s. Must be pthread, ticket, ttas, mcs or clh.\n", argv[i] + 7);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--batch=", 8) == 0)
+        {
+            batch_size = atoi(argv[i] + 8);
+            if (batch_size <= 0)
+            {
+                printf("Invalid batch size. Must be positive.\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            printf("Unknown option %s\n", argv[i]);
+            return 1;
+        }
+        else if (nargs < 3)
+            args[nargs++] = argv[i];
+    }
+
+    if (min_runs < 1 || max_runs < min_runs)
     {
-        printf("Usage: %s <program_type>\n", argv[0]);
-        printf("0 = Serial, 1 = Mutex, 2 = RWLock\n");
+        printf("Invalid run counts. Need 1 <= min-runs <= max-runs.\n");
         return 1;
     }
 
-    int program_type = atoi(argv[1]);
-    if (program_type < 0 || program_type > 2)
+    // With --impl or --gen-trace the only positional argument is the initial size
+    int size_arg = num_selected > 0 || gen_trace_path != NULL ? 1 : 2;
+    if (num_selected == 0 && gen_trace_path == NULL && nargs >= 2)
     {
-        printf("Invalid program type. Must be 0, 1, or 2.\n");
+        int program_type = atoi(args[1]);
+        if (program_type < 0 || program_type >= num_list_backends)
+        {
+            printf("Invalid program type. Must be between 0 and %d.\n", num_list_backends - 1);
+            return 1;
+        }
+        selected[num_selected++] = program_type;
+    }
+
+    if (num_selected == 0 && gen_trace_path == NULL)
+    {
+        printf("Usage: %s <program_type> [initial_size] [options]\n", argv[0]);
+        printf("       %s --impl=NAME[,NAME...] [initial_size] [options]\n", argv[0]);
+        printf("       %s --gen-trace=FILE [initial_size]\n", argv[0]);
+        for (int i = 0; i < num_list_backends; i++)
+            printf("  %2d = %-8s (%s)\n", i, list_backends[i].name, list_backends[i].label);
+        printf("--impl=LIST: benchmark each listed implementation (or all) into one CSV\n");
+        printf("--pool: allocate list nodes from per-thread pools instead of malloc/free\n");
+        printf("--shards=S: number of key-range shards for the sharded version (default 16)\n");
+        printf("--lock=NAME: lock used by the mutex version: pthread (default), ticket, ttas, mcs or clh\n");
+        printf("--batch=B: operations the mutex and rwlock versions apply per lock acquisition (default 1)\n");
+        printf("--n=N: initial list size (same as initial_size, default 1000)\n");
+        printf("--m=M: operations per run, split over the threads (default 10000)\n");
+        printf("--range=R: keys are drawn from [0, R) (default 65536, doubled until R >= 2n)\n");
+        printf("--mix=MEM,INS,DEL: one case with these Member/Insert/Delete percentages instead of cases 1-3\n");
+        printf("--dist=SPEC: operation keys: uniform (default), zipf[:THETA] (0.99), hotspot[:KEYS:OPS] (0.2:0.8), asc or desc\n");
+        printf("--latency: time every operation and report per-op p50/p99/p99.9/max latency\n");
+        printf("--perf: count cycles, instructions, cache and branch misses and context switches per run\n");
+        printf("--affinity=POLICY: pin worker threads: none (default), compact or scatter\n");
+        printf("--duration=T: run every worker for T seconds over its operations instead of once through them\n");
+        printf("--interval=S: with --duration, sample throughput every S seconds (default 0.1)\n");
+        printf("--warmup=W: unrecorded runs before each case (default 2)\n");
+        printf("--min-runs=N, --max-runs=N: recorded runs per case (default 10 and 30); --runs=N sets both\n");
+        printf("--ci=PCT: stop once the 95%% CI half-width is within PCT%% of the mean (default 5)\n");
+        printf("--build-threads=T: threads that build the initial list (default 1)\n");
+        printf("--json=FILE: append one JSON line per sweep to FILE\n");
+        printf("--gen-trace=FILE: write the initial keys and every run's operations to FILE, then exit\n");
+        printf("--trace=FILE: replay FILE instead of generating operations (the workload comes from it)\n");
         return 1;
     }
 
-    FILE *fp = fopen("performance_results_all_test.csv", "a"); // append mode
+    // Optional initial population size; the key range grows with it so
+    // that the list never covers more than half of the key space
+    if ((nargs > size_arg || workload_given) && trace_path != NULL)
+    {
+        printf("The workload comes from the trace; drop the size argument and --n/--m/--range/--mix/--dist.\n");
+        return 1;
+    }
+    if (nargs > size_arg)
+    {
+        n = atoi(args[size_arg]);
+        if (n <= 0)
+        {
+            printf("Invalid initial size. Must be positive.\n");
+            return 1;
+        }
+    }
+    if (!range_given)
+    {
+        while (key_range < 2 * n && key_range < TRACE_MAX_KEY_RANGE)
+            key_range *= 2;
+    }
+    if (n > key_range)
+    {
+        printf("Key range %d is too small for %d distinct initial keys.\n", key_range, n);
+        return 1;
+    }
+    key_dist_describe(&key_dist, dist_label, sizeof(dist_label));
+    key_dist_prepare(key_range);
+
+    if (gen_trace_path != NULL)
+        return generate_trace(gen_trace_path) == 0 ? 0 : 1;
+
+    // Every backend replays the same mapped operations
+    if (trace_path != NULL)
+    {
+        if (op_trace_load(trace_path) != 0)
+            return 1;
+        op_trace_params(&n, &key_range, &m);
+        num_cases = op_trace_num_cases();
+        snprintf(dist_label, sizeof(dist_label), "%s", op_trace_dist());
+        printf("Replaying trace %s\n", trace_path);
+    }
+
+    if (shard_count > key_range)
+        shard_count = key_range;
+    printf("Initial size n = %d, m = %d, key range = [0, %d), keys %s, allocator = %s\n",
+           n, m, key_range, dist_label, use_node_pool ? "pool" : "malloc");
+    if (num_cases == 1 && !trace_loaded)
+        printf("Operation mix: %.4g%% Member, %.4g%% Insert, %.4g%% Delete\n",
+               custom_mix[0] * 100, custom_mix[1] * 100, custom_mix[2] * 100);
+
+    // Pin before the first worker starts; the serial version runs where worker 0 would
+    affinity_init();
+    affinity_pin_thread(0);
+
+    // Runs at non-default sizes go to their own file so rows stay comparable
+    char filename[64];
+    if (n != 1000)
+        snprintf(filename, sizeof(filename), "performance_results_v%d_n%d.csv", CSV_SCHEMA, n);
+    else
+        snprintf(filename, sizeof(filename), "performance_results_v%d_all_test.csv", CSV_SCHEMA);
+
+    FILE *fp = fopen(filename, "a+"); // append mode, header readable
     if (!fp)
     {
         printf("Error opening file\n");
         return 1;
     }
 
+    fseek(fp, 0, SEEK_END);
     if (ftell(fp) == 0)
     { // if file is empty, write header
-        fprintf(fp, "ProgramType,Case,Average(us),StdDev(us),Min(us),Max(us),95%% CI Lower(us),95%% CI Upper(us),Thread Count\n");
+        fprintf(fp, "%s\n", CSV_HEADER);
+    }
+    else
+    {
+        // Never append rows under a header with different columns
+        char header[1024] = "";
+        rewind(fp);
+        if (!fgets(header, sizeof(header), fp) || strcspn(header, "\r\n") != strlen(CSV_HEADER) ||
+            strncmp(header, CSV_HEADER, strlen(CSV_HEADER)) != 0)
+        {
+            printf("%s has different columns than this build writes; move it aside or bump CSV_SCHEMA\n", filename);
+            fclose(fp);
+            return 1;
+        }
+        fseek(fp, 0, SEEK_END);
     }
 
-    run_performance_tests(program_type, fp);
+    if (json_path != NULL)
+    {
+        json_fp = fopen(json_path, "a");
+        if (!json_fp)
+        {
+            perror(json_path);
+            return 1;
+        }
+    }
+
+    // Every selected backend sees the same sizes and options
+    for (int i = 0; i < num_selected; i++)
+    {
+        printf("\n##### %s #####\n", list_backends[selected[i]].label);
+        run_performance_tests(selected[i], fp);
+        fflush(fp);
+    }
 
     fclose(fp);
+    if (json_fp != NULL)
+        fclose(json_fp);
+    op_trace_unload();
+    perf_counters_thread_exit();
     return 0;
 }
@@ -2,7 +2,15 @@
 #include <stdlib.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "list_lock.h"
+#include "lock_stats.h"
 
 typedef struct
 {
@@ -10,67 +18,100 @@ typedef struct
     int m;
     double mMember, mInsert, mDelete;
     int thread_count;
-    pthread_mutex_t *mutex;
+    list_lock_t *mutex;
+    atomic_int next_id;
+    double *thread_us; // time each thread spent executing its operations
 } thread_params_t;
 
-void *thread_worker(void *args)
+static void *thread_worker(void *args)
 {
     thread_params_t *params = (thread_params_t *)args;
 
-    // Thread-local RNG seed
-    unsigned int seed = time(NULL) ^ (unsigned long)pthread_self();
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
 
-    // Calculate how many of each operation this thread should perform
-    int Mem = (int)(params->mMember * params->m / params->thread_count);
-    int Ins = (int)(params->mInsert * params->m / params->thread_count);
-    int Del = (int)(params->mDelete * params->m / params->thread_count);
-
-    int totalOps = Mem + Ins + Del;
-
-    // Step 1: Create an array of operations
-    int *ops = malloc(totalOps * sizeof(int));
-    int idx = 0;
-    for (int i = 0; i < Mem; i++) ops[idx++] = 2;  // Member
-    for (int i = 0; i < Ins; i++) ops[idx++] = 0;  // Insert
-    for (int i = 0; i < Del; i++) ops[idx++] = 1;  // Delete
-
-    // Step 2: Shuffle the array (Fisher-Yates)
-    for (int i = totalOps - 1; i > 0; i--)
+    // Step 3: Execute operations
+    list_lock_ctx_t ctx;
+    list_lock_ctx_init(&ctx);
+    LOCK_STATS_DECLARE(lock_stats);
+    struct timeval begin, end;
+    thread_pool_begin_ops();
+    gettimeofday(&begin, NULL);
+
+    if (batch_size > 1)
     {
-        int j = rand_r(&seed) % (i + 1);
-        int tmp = ops[i];
-        ops[i] = ops[j];
-        ops[j] = tmp;
+        // Sort each batch before locking so the critical section is one pass
+        struct list_op_s *batch = malloc(batch_size * sizeof(struct list_op_s));
+        for (int i = 0; duration_more_ops(&i, totalOps, batch_size); i += batch_size)
+        {
+            int count = totalOps - i < batch_size ? totalOps - i : batch_size;
+            for (int j = 0; j < count; j++)
+            {
+                batch[j].op = TRACE_OP(ops[i + j]);
+                batch[j].value = TRACE_KEY(ops[i + j]);
+            }
+            uint64_t op_start = latency_start();
+            SortBatch(batch, count);
+
+            LOCK_STATS_WAIT(lock_stats);
+            list_lock_acquire(params->mutex, &ctx);
+            LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_WRITE);
+            ApplyBatch(batch, count, params->head);
+            LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_WRITE);
+            list_lock_release(params->mutex, &ctx);
+
+            latency_record_batch(batch, count, op_start);
+        }
+        free(batch);
     }
-
-    // Step 3: Execute operations
-    for (int i = 0; i < totalOps; i++)
+    else
     {
-        int val = rand_r(&seed) % 65536;
-
-        pthread_mutex_lock(params->mutex);
-
-        if (ops[i] == 0)
-            Insert(val, params->head);
-        else if (ops[i] == 1)
-            Delete(val, params->head);
-        else
-            Member(val, *(params->head));
-
-        pthread_mutex_unlock(params->mutex);
+        for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+        {
+            int op = TRACE_OP(ops[i]);
+            int val = TRACE_KEY(ops[i]);
+            uint64_t op_start = latency_start();
+
+            LOCK_STATS_WAIT(lock_stats);
+            list_lock_acquire(params->mutex, &ctx);
+            LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_WRITE);
+
+            if (op == 0)
+                Insert(val, params->head);
+            else if (op == 1)
+                Delete(val, params->head);
+            else
+                Member(val, *(params->head));
+
+            LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_WRITE);
+            list_lock_release(params->mutex, &ctx);
+
+            latency_record(op, op_start);
+        }
     }
 
-    free(ops);
+    gettimeofday(&end, NULL);
+    thread_pool_end_ops();
+    params->thread_us[atomic_fetch_add(&params->next_id, 1)] =
+        (end.tv_sec - begin.tv_sec) * 1000000.0 + (end.tv_usec - begin.tv_usec);
+    list_lock_ctx_destroy(&ctx);
+    LOCK_STATS_PUBLISH(lock_stats);
+
+    op_stream_close(&stream);
     return NULL;
 }
 
-double run_threads(struct list_node_s **list_head,
-                   int m,
-                   double mMember,
-                   double mInsert,
-                   double mDelete,
-                   int thread_count,
-                   int program_type)
+double run_threads_mutex(struct list_node_s **list_head,
+                         int m,
+                         double mMember,
+                         double mInsert,
+                         double mDelete,
+                         int thread_count,
+                         int program_type)
 {
     if (program_type != 1)
     {
@@ -78,37 +119,37 @@ double run_threads(struct list_node_s **list_head,
         exit(EXIT_FAILURE);
     }
     srand(time(NULL)); // random seed
-    pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
-    pthread_mutex_t mutex;
-    pthread_mutex_init(&mutex, NULL);
+    list_lock_t mutex;
+    list_lock_init(&mutex, lock_kind);
 
     thread_params_t params = {list_head, m, mMember, mInsert, mDelete,
                               thread_count, &mutex};
+    atomic_init(&params.next_id, 0);
+    params.thread_us = malloc(thread_count * sizeof(double));
 
+    printf("Running in mutex mode (%s lock, batch %d) with %d threads and %d operations\n",
+           lock_kind_name(lock_kind), batch_size, thread_count, m);
 
-    printf("Running in mutex mode with %d threads and %d operations\n", thread_count, m);
-
-    // Start timing
-    struct timeval start, stop;
-    gettimeofday(&start, NULL);
-
-    for (long i = 0; i < thread_count; i++)
-        pthread_create(&threads[i], NULL, thread_worker, &params);
-
-    for (int i = 0; i < thread_count; i++)
-        pthread_join(threads[i], NULL);
-
-    // Stop timing
-    gettimeofday(&stop, NULL);
-    unsigned long elapsed_time = (stop.tv_sec - start.tv_sec) * 1000000 +
-                                 stop.tv_usec - start.tv_usec;
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
 
     // Free the list
     destructor(*list_head); // free all nodes
     *list_head = NULL;
 
-    pthread_mutex_destroy(&mutex);
-    free(threads);
+    // Jain's fairness index over per-thread throughput: 1 when every
+    // thread got through its (equal) share of operations equally fast
+    double sum = 0, sum_sq = 0;
+    for (int i = 0; i < thread_count; i++)
+    {
+        double rate = params.thread_us[i] > 0 ? 1.0 / params.thread_us[i] : 0;
+        sum += rate;
+        sum_sq += rate * rate;
+    }
+    run_fairness = sum_sq > 0 ? (sum * sum) / (thread_count * sum_sq) : 1.0;
+
+    list_lock_destroy(&mutex);
+    free(params.thread_us);
 
     return elapsed_time;
 }
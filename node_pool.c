@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "node_pool.h"
+
+int use_node_pool = 0;
+
+// Every slab is kept on a chain so destructor can free them in bulk
+struct pool_slab_s
+{
+    struct pool_slab_s *next;
+    struct list_node_s nodes[NODE_POOL_SLAB];
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct pool_slab_s *slabs = NULL;          // every slab ever carved
+static struct list_node_s *shared_free = NULL;    // free nodes chained via next
+static int shared_count = 0;
+static unsigned long pool_generation = 1;         // bumped by node_pool_release_all
+
+// Per-thread cache; stale once pool_generation moves on
+static __thread struct list_node_s *cache = NULL;
+static __thread int cache_count = 0;
+static __thread unsigned long cache_generation = 0;
+
+// Move up to NODE_POOL_BATCH nodes from the shared pool into this thread's cache
+static void pool_refill(void)
+{
+    pthread_mutex_lock(&pool_mutex);
+
+    if (cache_generation != pool_generation)
+    {
+        // Slabs were released since this thread last used the pool
+        cache = NULL;
+        cache_count = 0;
+        cache_generation = pool_generation;
+    }
+
+    if (shared_count == 0)
+    {
+        struct pool_slab_s *slab = malloc(sizeof(struct pool_slab_s));
+        if (slab == NULL)
+        {
+            pthread_mutex_unlock(&pool_mutex);
+            fprintf(stderr, "Node pool: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        slab->next = slabs;
+        slabs = slab;
+        for (int i = 0; i < NODE_POOL_SLAB; i++)
+        {
+            slab->nodes[i].next = shared_free;
+            shared_free = &slab->nodes[i];
+        }
+        shared_count += NODE_POOL_SLAB;
+    }
+
+    for (int i = 0; i < NODE_POOL_BATCH && shared_count > 0; i++)
+    {
+        struct list_node_s *node = shared_free;
+        shared_free = node->next;
+        shared_count--;
+        node->next = cache;
+        cache = node;
+        cache_count++;
+    }
+
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+struct list_node_s *node_pool_alloc(void)
+{
+    if (cache == NULL || cache_generation != pool_generation)
+        pool_refill();
+
+    struct list_node_s *node = cache;
+    cache = node->next;
+    cache_count--;
+    return node;
+}
+
+void node_pool_free(struct list_node_s *node)
+{
+    if (cache_generation != pool_generation)
+    {
+        cache = NULL;
+        cache_count = 0;
+        cache_generation = pool_generation;
+    }
+
+    node->next = cache;
+    cache = node;
+    cache_count++;
+
+    // Keep caches bounded: give a batch back once we hold two
+    if (cache_count >= 2 * NODE_POOL_BATCH)
+    {
+        struct list_node_s *first = cache;
+        struct list_node_s *last = cache;
+        for (int i = 1; i < NODE_POOL_BATCH; i++)
+            last = last->next;
+        cache = last->next;
+        cache_count -= NODE_POOL_BATCH;
+
+        pthread_mutex_lock(&pool_mutex);
+        last->next = shared_free;
+        shared_free = first;
+        shared_count += NODE_POOL_BATCH;
+        pthread_mutex_unlock(&pool_mutex);
+    }
+}
+
+void node_pool_release_all(void)
+{
+    pthread_mutex_lock(&pool_mutex);
+    struct pool_slab_s *slab = slabs;
+    while (slab != NULL)
+    {
+        struct pool_slab_s *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    slabs = NULL;
+    shared_free = NULL;
+    shared_count = 0;
+    pool_generation++; // invalidates every thread cache
+    pthread_mutex_unlock(&pool_mutex);
+}
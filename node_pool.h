@@ -0,0 +1,22 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include "linkedlist.h"
+
+// Slab allocator for list_node_s: each thread keeps a private free list
+// and refills it in batches from a shared pool, so a successful Insert or
+// Delete normally touches no shared allocator state.
+
+#define NODE_POOL_SLAB 4096 // nodes carved per slab
+#define NODE_POOL_BATCH 64  // nodes moved between a thread cache and the shared pool
+
+// Nonzero when alloc_node/free_node should use the pool instead of malloc/free
+extern int use_node_pool;
+
+struct list_node_s *node_pool_alloc(void);
+void node_pool_free(struct list_node_s *node);
+
+// Free every slab at once; all nodes handed out by the pool become invalid
+void node_pool_release_all(void);
+
+#endif
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "op_trace.h"
+#include "key_dist.h"
+
+// File layout, in native byte order:
+//   trace_header_s
+//   n initial keys (uint32_t, ascending), padded to a multiple of 8 bytes
+//   num_sections x trace_section_s, one per (case, thread count)
+//   records: each section's thread_count partitions of ops_per_thread records
+#define TRACE_MAGIC 0x4352544c // "LTRC"
+#define TRACE_VERSION 2
+#define TRACE_KEYS_BYTES(n) (((size_t)(n) + 1) / 2 * 2 * sizeof(uint32_t))
+
+struct trace_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n;
+    uint32_t key_range;
+    uint32_t m;
+    uint32_t num_sections;
+    char dist[32]; // key distribution label, see key_dist_describe
+};
+
+struct trace_section_s
+{
+    uint32_t case_num;
+    uint32_t thread_count;
+    uint32_t ops_per_thread;
+    uint32_t reserved;
+    uint64_t offset; // of the first partition, from the start of the file
+    double mix[3];   // Member, Insert and Delete fractions of the case
+};
+
+int trace_loaded = 0;
+
+static const unsigned char *trace_map = NULL;
+static size_t trace_size = 0;
+static const struct trace_header_s *trace_header = NULL;
+static const struct trace_section_s *trace_sections = NULL;
+static const struct trace_section_s *selected_section = NULL;
+
+// The per-thread op counts and Fisher-Yates shuffle the workers have
+// always used, with the keys drawn up front from key_dist
+static int generate_ops(uint32_t **out, int m, double mMember, double mInsert, double mDelete,
+                        int thread_index, int thread_count, unsigned int *seed)
+{
+    // Calculate how many of each operation this thread should perform
+    int Mem = (int)(mMember * m / thread_count);
+    int Ins = (int)(mInsert * m / thread_count);
+    int Del = (int)(mDelete * m / thread_count);
+
+    int totalOps = Mem + Ins + Del;
+
+    // Step 1: Create an array of operations
+    uint32_t *ops = malloc((totalOps > 0 ? totalOps : 1) * sizeof(uint32_t));
+    int idx = 0;
+    for (int i = 0; i < Mem; i++) ops[idx++] = LIST_OP_MEMBER;
+    for (int i = 0; i < Ins; i++) ops[idx++] = LIST_OP_INSERT;
+    for (int i = 0; i < Del; i++) ops[idx++] = LIST_OP_DELETE;
+
+    // Step 2: Shuffle the array (Fisher-Yates)
+    for (int i = totalOps - 1; i > 0; i--)
+    {
+        int j = rand_r(seed) % (i + 1);
+        uint32_t tmp = ops[i];
+        ops[i] = ops[j];
+        ops[j] = tmp;
+    }
+
+    // Step 3: Attach a key to every operation
+    for (int i = 0; i < totalOps; i++)
+        ops[i] = TRACE_RECORD(ops[i], key_dist_next(i, thread_index, thread_count, seed));
+
+    *out = ops;
+    return totalOps;
+}
+
+void op_stream_open(op_stream_t *stream, int thread_index, int m,
+                    double mMember, double mInsert, double mDelete, int thread_count)
+{
+    if (trace_loaded)
+    {
+        const struct trace_section_s *section = selected_section;
+        if (section == NULL || (int)section->thread_count != thread_count ||
+            thread_index < 0 || thread_index >= thread_count)
+        {
+            fprintf(stderr, "Trace has no partition %d of %d for this run.\n", thread_index, thread_count);
+            exit(EXIT_FAILURE);
+        }
+
+        // Zero copy: the records are read straight from the mapping
+        stream->ops = (const uint32_t *)(trace_map + section->offset) +
+                      (size_t)thread_index * section->ops_per_thread;
+        stream->count = section->ops_per_thread;
+        stream->owned = NULL;
+        return;
+    }
+
+    // Thread-local RNG seed
+    unsigned int seed = time(NULL) ^ (unsigned long)pthread_self();
+    stream->count = generate_ops(&stream->owned, m, mMember, mInsert, mDelete,
+                                 thread_index, thread_count, &seed);
+    stream->ops = stream->owned;
+}
+
+void op_stream_close(op_stream_t *stream)
+{
+    free(stream->owned);
+    stream->owned = NULL;
+    stream->ops = NULL;
+    stream->count = 0;
+}
+
+int op_trace_write(const char *path, const int *initial_keys, int n, int range, int m,
+                   const double mixes[][3], int num_cases,
+                   const int *thread_counts, int num_thread_counts)
+{
+    if (range > TRACE_MAX_KEY_RANGE)
+    {
+        fprintf(stderr, "Key range %d does not fit in a trace record.\n", range);
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        perror(path);
+        return -1;
+    }
+
+    int num_sections = num_cases * num_thread_counts;
+    struct trace_header_s header = {TRACE_MAGIC, TRACE_VERSION, n, range, m, num_sections, ""};
+    key_dist_describe(&key_dist, header.dist, sizeof(header.dist));
+    fwrite(&header, sizeof(header), 1, fp);
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t key = initial_keys[i];
+        fwrite(&key, sizeof(key), 1, fp);
+    }
+    if (n % 2 != 0) // keep the section table 8-byte aligned
+    {
+        uint32_t pad = 0;
+        fwrite(&pad, sizeof(pad), 1, fp);
+    }
+
+    // Section table first, so every partition's offset is known up front
+    uint64_t offset = sizeof(header) + TRACE_KEYS_BYTES(n) +
+                      (uint64_t)num_sections * sizeof(struct trace_section_s);
+    for (int c = 0; c < num_cases; c++)
+    {
+        for (int t = 0; t < num_thread_counts; t++)
+        {
+            int thread_count = thread_counts[t];
+            struct trace_section_s section = {c + 1, thread_count, 0, 0, offset,
+                                              {mixes[c][0], mixes[c][1], mixes[c][2]}};
+            section.ops_per_thread = (int)(mixes[c][0] * m / thread_count) +
+                                     (int)(mixes[c][1] * m / thread_count) +
+                                     (int)(mixes[c][2] * m / thread_count);
+            fwrite(&section, sizeof(section), 1, fp);
+            offset += (uint64_t)thread_count * section.ops_per_thread * sizeof(uint32_t);
+        }
+    }
+
+    // One continuous RNG stream, so every partition differs
+    unsigned int seed = time(NULL);
+    for (int c = 0; c < num_cases; c++)
+    {
+        for (int t = 0; t < num_thread_counts; t++)
+        {
+            for (int th = 0; th < thread_counts[t]; th++)
+            {
+                uint32_t *ops;
+                int count = generate_ops(&ops, m, mixes[c][0], mixes[c][1], mixes[c][2],
+                                         th, thread_counts[t], &seed);
+                fwrite(ops, sizeof(uint32_t), count, fp);
+                free(ops);
+            }
+        }
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int op_trace_load(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct trace_header_s))
+    {
+        fprintf(stderr, "%s is not a trace file.\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (map == MAP_FAILED)
+    {
+        perror(path);
+        return -1;
+    }
+    trace_map = map;
+    trace_size = st.st_size;
+    trace_header = map;
+
+    // Check that the header, the table and every partition are in the file
+    const struct trace_header_s *h = trace_header;
+    size_t table = sizeof(*h) + TRACE_KEYS_BYTES(h->n);
+    int valid = h->magic == TRACE_MAGIC && h->version == TRACE_VERSION &&
+                h->key_range > 0 && h->key_range <= TRACE_MAX_KEY_RANGE &&
+                memchr(h->dist, '\0', sizeof(h->dist)) != NULL &&
+                table + (size_t)h->num_sections * sizeof(struct trace_section_s) <= trace_size;
+    trace_sections = (const struct trace_section_s *)(trace_map + table);
+    for (uint32_t s = 0; valid && s < h->num_sections; s++)
+    {
+        const struct trace_section_s *section = &trace_sections[s];
+        valid = section->thread_count > 0 && section->case_num > 0 &&
+                section->offset + (uint64_t)section->thread_count * section->ops_per_thread * sizeof(uint32_t) <= trace_size;
+    }
+    const uint32_t *keys = (const uint32_t *)(trace_map + sizeof(*h));
+    for (uint32_t i = 0; valid && i < h->n; i++)
+        valid = keys[i] < h->key_range && (i == 0 || keys[i - 1] < keys[i]);
+    if (!valid)
+    {
+        fprintf(stderr, "%s is not a valid version %d trace file.\n", path, TRACE_VERSION);
+        op_trace_unload();
+        return -1;
+    }
+
+    trace_loaded = 1;
+    return 0;
+}
+
+void op_trace_unload(void)
+{
+    if (trace_map != NULL)
+        munmap((void *)trace_map, trace_size);
+    trace_map = NULL;
+    trace_size = 0;
+    trace_header = NULL;
+    trace_sections = NULL;
+    selected_section = NULL;
+    trace_loaded = 0;
+}
+
+void op_trace_params(int *n, int *key_range, int *m)
+{
+    *n = trace_header->n;
+    *key_range = trace_header->key_range;
+    *m = trace_header->m;
+}
+
+const char *op_trace_dist(void)
+{
+    return trace_header->dist;
+}
+
+int op_trace_num_cases(void)
+{
+    int num_cases = 0;
+    for (uint32_t s = 0; s < trace_header->num_sections; s++)
+    {
+        if ((int)trace_sections[s].case_num > num_cases)
+            num_cases = trace_sections[s].case_num;
+    }
+    return num_cases;
+}
+
+int op_trace_case_mix(int case_num, double mix[3])
+{
+    for (uint32_t s = 0; s < trace_header->num_sections; s++)
+    {
+        if ((int)trace_sections[s].case_num == case_num)
+        {
+            for (int i = 0; i < 3; i++)
+                mix[i] = trace_sections[s].mix[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const uint32_t *op_trace_initial_keys(void)
+{
+    return (const uint32_t *)(trace_map + sizeof(struct trace_header_s));
+}
+
+int op_trace_select(int case_num, int thread_count)
+{
+    selected_section = NULL;
+    for (uint32_t s = 0; s < trace_header->num_sections; s++)
+    {
+        if ((int)trace_sections[s].case_num == case_num &&
+            (int)trace_sections[s].thread_count == thread_count)
+        {
+            selected_section = &trace_sections[s];
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef OP_TRACE_H
+#define OP_TRACE_H
+
+#include <stdint.h>
+#include "linkedlist.h"
+
+// Operation streams for the worker threads. Without a trace each worker
+// generates its own stream during setup (shuffled op types, keys drawn
+// from key_dist), so no random numbers are drawn inside the timed loop.
+// With a trace loaded (--trace=FILE) every worker instead reads its
+// partition of the mmapped file in place, and every backend replays
+// byte-identical input.
+
+// One record: the op type (LIST_OP_*) in the top two bits, the key below
+#define TRACE_KEY_BITS 30
+#define TRACE_MAX_KEY_RANGE (1 << TRACE_KEY_BITS)
+#define TRACE_OP(rec) ((int)((rec) >> TRACE_KEY_BITS))
+#define TRACE_KEY(rec) ((int)((rec) & (TRACE_MAX_KEY_RANGE - 1)))
+#define TRACE_RECORD(op, key) (((uint32_t)(op) << TRACE_KEY_BITS) | (uint32_t)(key))
+
+typedef struct
+{
+    const uint32_t *ops;
+    int count;
+    uint32_t *owned; // generated records to free; NULL when they live in the trace
+} op_stream_t;
+
+// Operations of thread thread_index out of thread_count for the current
+// run: the matching trace partition, or a freshly generated stream
+void op_stream_open(op_stream_t *stream, int thread_index, int m,
+                    double mMember, double mInsert, double mDelete, int thread_count);
+void op_stream_close(op_stream_t *stream);
+
+// Write a trace with the sorted initial keys and, for every case and
+// thread count, one partition per thread. mixes[c] holds the Member,
+// Insert and Delete fractions of case c + 1. Returns 0 on success.
+int op_trace_write(const char *path, const int *initial_keys, int n, int range, int m,
+                   const double mixes[][3], int num_cases,
+                   const int *thread_counts, int num_thread_counts);
+
+// Map a trace for replay; returns 0 on success
+int op_trace_load(const char *path);
+void op_trace_unload(void);
+
+// Nonzero while a trace is loaded
+extern int trace_loaded;
+
+// Parameters and initial keys (ascending) of the loaded trace
+void op_trace_params(int *n, int *key_range, int *m);
+const char *op_trace_dist(void);
+int op_trace_num_cases(void);
+// Member, Insert and Delete fractions of a case; returns 0 if it is missing
+int op_trace_case_mix(int case_num, double mix[3]);
+const uint32_t *op_trace_initial_keys(void);
+
+// Choose the partitions later op_stream_open calls read; returns 0 when
+// the trace has no section for this case and thread count
+int op_trace_select(int case_num, int thread_count);
+
+#endif
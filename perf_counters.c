@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.h"
+#include "thread_pool.h"
+
+#define PERF_CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+enum
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    PERF_NUM_EVENTS
+};
+
+#define PERF_CSV_COLUMNS 7
+
+static const struct
+{
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} perf_events[PERF_NUM_EVENTS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1D misses", PERF_TYPE_HW_CACHE, PERF_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {"LLC misses", PERF_TYPE_HW_CACHE, PERF_CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {"branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"context switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+// One thread's counts over one run; valid[e] is 0 when e could not be read
+struct perf_sample_s
+{
+    uint64_t value[PERF_NUM_EVENTS];
+    int valid[PERF_NUM_EVENTS];
+};
+
+// Totals over every run of the current case
+struct perf_total_s
+{
+    double value[PERF_NUM_EVENTS];
+    int samples[PERF_NUM_EVENTS]; // thread runs that contributed
+};
+
+int measure_perf = 0;
+
+static atomic_int warned[PERF_NUM_EVENTS]; // unavailable counters are reported once
+
+static struct perf_sample_s *run_samples = NULL; // one per worker of the current run
+static int run_samples_capacity = 0;
+static int run_thread_count = 0;
+static int case_runs = 0;
+static struct perf_total_s case_total;
+static struct perf_total_s *case_threads = NULL; // per worker index, over the case's runs
+static int case_threads_capacity = 0;
+
+// The calling thread's counters, opened on first use; -1 if unavailable
+static __thread int perf_fds[PERF_NUM_EVENTS];
+static __thread int perf_opened = 0;
+
+static int perf_open(int event)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_events[event].type;
+    attr.config = perf_events[event].config;
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Count the kernel too where allowed (context switches happen there),
+    // otherwise fall back to user space only
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM))
+    {
+        attr.exclude_kernel = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    if (fd < 0 && atomic_exchange(&warned[event], 1) == 0)
+        fprintf(stderr, "perf: %s unavailable (%s), column left empty\n", perf_events[event].name, strerror(errno));
+    return fd;
+}
+
+void perf_counters_begin(void)
+{
+    if (!measure_perf)
+        return;
+
+    if (!perf_opened)
+    {
+        for (int e = 0; e < PERF_NUM_EVENTS; e++)
+            perf_fds[e] = perf_open(e);
+        perf_opened = 1;
+    }
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+    {
+        if (perf_fds[e] >= 0)
+        {
+            ioctl(perf_fds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(perf_fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void perf_counters_end(void)
+{
+    if (!measure_perf || !perf_opened)
+        return;
+
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+    {
+        if (perf_fds[e] >= 0)
+            ioctl(perf_fds[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    // The serial version runs on the main thread, outside the pool
+    int thread = thread_pool_index();
+    if (thread < 0)
+        thread = 0;
+    struct perf_sample_s *sample = &run_samples[thread];
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+    {
+        uint64_t data[3]; // value, time enabled, time running
+        sample->valid[e] = perf_fds[e] >= 0 && read(perf_fds[e], data, sizeof(data)) == sizeof(data) &&
+                           data[2] > 0;
+        if (!sample->valid[e])
+            continue;
+        // Scale up if the PMU was multiplexed between counters
+        sample->value[e] = data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+    }
+}
+
+void perf_counters_thread_exit(void)
+{
+    if (!perf_opened)
+        return;
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+    {
+        if (perf_fds[e] >= 0)
+            close(perf_fds[e]);
+    }
+    perf_opened = 0;
+}
+
+void perf_run_begin(int thread_count)
+{
+    if (!measure_perf)
+        return;
+
+    if (thread_count > run_samples_capacity)
+    {
+        run_samples = realloc(run_samples, thread_count * sizeof(struct perf_sample_s));
+        run_samples_capacity = thread_count;
+    }
+    memset(run_samples, 0, thread_count * sizeof(struct perf_sample_s));
+    run_thread_count = thread_count;
+}
+
+void perf_run_end(void)
+{
+    if (!measure_perf)
+        return;
+
+    if (run_thread_count > case_threads_capacity)
+    {
+        case_threads = realloc(case_threads, run_thread_count * sizeof(struct perf_total_s));
+        memset(case_threads + case_threads_capacity, 0,
+               (run_thread_count - case_threads_capacity) * sizeof(struct perf_total_s));
+        case_threads_capacity = run_thread_count;
+    }
+
+    for (int t = 0; t < run_thread_count; t++)
+    {
+        for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        {
+            if (!run_samples[t].valid[e])
+                continue;
+            case_total.value[e] += run_samples[t].value[e];
+            case_total.samples[e]++;
+            case_threads[t].value[e] += run_samples[t].value[e];
+            case_threads[t].samples[e]++;
+        }
+    }
+    case_runs++;
+}
+
+void perf_case_reset(void)
+{
+    memset(&case_total, 0, sizeof(case_total));
+    if (case_threads != NULL)
+        memset(case_threads, 0, case_threads_capacity * sizeof(struct perf_total_s));
+    case_runs = 0;
+}
+
+// A counter is only reported when every thread of every run delivered it
+static int complete(const struct perf_total_s *total, int e, int expected)
+{
+    return expected > 0 && total->samples[e] == expected;
+}
+
+void perf_case_print(int thread_count, double ops_per_run)
+{
+    if (!measure_perf || case_runs == 0)
+        return;
+
+    const struct perf_total_s *total = &case_total;
+    int expected = case_runs * thread_count;
+    double ops = ops_per_run * case_runs;
+
+    printf("Perf counters:");
+    const char *sep = " ";
+    for (int e = 0; e < PERF_CONTEXT_SWITCHES; e++)
+    {
+        if (complete(total, e, expected))
+        {
+            printf("%s%s/op %.1f", sep, perf_events[e].name, total->value[e] / ops);
+            sep = ", ";
+        }
+    }
+    if (complete(total, PERF_CYCLES, expected) && complete(total, PERF_INSTRUCTIONS, expected))
+        printf("%sIPC %.2f", sep, total->value[PERF_INSTRUCTIONS] / total->value[PERF_CYCLES]);
+    if (complete(total, PERF_CONTEXT_SWITCHES, expected))
+    {
+        printf("%scontext switches/run %.1f", sep, total->value[PERF_CONTEXT_SWITCHES] / case_runs);
+        sep = ", ";
+    }
+    printf("%s\n", sep[0] == ' ' ? " none available" : "");
+
+    // Per thread, to spot a thread that stalls or gets descheduled
+    if (thread_count > 1 && sep[0] != ' ')
+    {
+        double thread_ops = ops / thread_count;
+        for (int t = 0; t < thread_count; t++)
+        {
+            const struct perf_total_s *thread = &case_threads[t];
+            printf("  thread %d:", t);
+            if (complete(thread, PERF_CYCLES, case_runs))
+                printf(" cycles/op %.0f", thread->value[PERF_CYCLES] / thread_ops);
+            if (complete(thread, PERF_CYCLES, case_runs) && complete(thread, PERF_INSTRUCTIONS, case_runs))
+                printf(" IPC %.2f", thread->value[PERF_INSTRUCTIONS] / thread->value[PERF_CYCLES]);
+            if (complete(thread, PERF_L1D_MISSES, case_runs))
+                printf(" L1D-misses/op %.1f", thread->value[PERF_L1D_MISSES] / thread_ops);
+            if (complete(thread, PERF_CONTEXT_SWITCHES, case_runs))
+                printf(" context-switches/run %.1f", thread->value[PERF_CONTEXT_SWITCHES] / case_runs);
+            printf("\n");
+        }
+    }
+}
+
+void perf_case_csv(char *buf, size_t len, int thread_count, double ops_per_run)
+{
+    int expected = case_runs * thread_count;
+    double ops = ops_per_run * case_runs;
+    int ok[PERF_NUM_EVENTS];
+    for (int e = 0; e < PERF_NUM_EVENTS; e++)
+        ok[e] = measure_perf && complete(&case_total, e, expected);
+    const double *v = case_total.value;
+
+    // Cycles/op, instructions/op, IPC, L1D/LLC/branch misses per op, context switches per run
+    int have[PERF_CSV_COLUMNS] = {ok[PERF_CYCLES], ok[PERF_INSTRUCTIONS], ok[PERF_CYCLES] && ok[PERF_INSTRUCTIONS],
+                                  ok[PERF_L1D_MISSES], ok[PERF_LLC_MISSES], ok[PERF_BRANCH_MISSES],
+                                  ok[PERF_CONTEXT_SWITCHES]};
+    double values[PERF_CSV_COLUMNS] = {0};
+    if (expected > 0)
+    {
+        values[0] = v[PERF_CYCLES] / ops;
+        values[1] = v[PERF_INSTRUCTIONS] / ops;
+        values[2] = v[PERF_CYCLES] > 0 ? v[PERF_INSTRUCTIONS] / v[PERF_CYCLES] : 0;
+        values[3] = v[PERF_L1D_MISSES] / ops;
+        values[4] = v[PERF_LLC_MISSES] / ops;
+        values[5] = v[PERF_BRANCH_MISSES] / ops;
+        values[6] = v[PERF_CONTEXT_SWITCHES] / case_runs;
+    }
+
+    buf[0] = '\0';
+    for (int c = 0; c < PERF_CSV_COLUMNS; c++)
+    {
+        size_t used = strlen(buf);
+        if (have[c])
+            snprintf(buf + used, len - used, ",%.3f", values[c]);
+        else
+            snprintf(buf + used, len - used, ",-");
+    }
+}
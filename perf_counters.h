@@ -0,0 +1,35 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stddef.h>
+
+// Hardware and software counters per run (--perf) through perf_event_open:
+// cycles, instructions, L1D and LLC read misses, branch misses and
+// context switches. Every worker counts its own thread over its operation
+// phase; the pool calls perf_counters_begin/end from thread_pool_begin_ops
+// and thread_pool_end_ops. A counter the kernel or the hardware refuses
+// (no PMU in a VM, perf_event_paranoid) is reported once and left out.
+
+// Nonzero when --perf is given; set by main.c
+extern int measure_perf;
+
+// Start and stop the calling thread's counters around its operation loop
+void perf_counters_begin(void);
+void perf_counters_end(void);
+
+// Close the calling thread's counters, before it exits
+void perf_counters_thread_exit(void);
+
+// Clear the per-thread samples of thread_count workers before a run, and
+// add them to the case totals after it
+void perf_run_begin(int thread_count);
+void perf_run_end(void);
+
+// Case totals: clear them, print them per operation (ops_per_run
+// operations over thread_count threads), and format them as the perf CSV
+// columns (each starting with a comma, "-" where a counter is missing)
+void perf_case_reset(void);
+void perf_case_print(int thread_count, double ops_per_run);
+void perf_case_csv(char *buf, size_t len, int thread_count, double ops_per_run);
+
+#endif
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include "qsbr.h"
+
+void qsbr_init(qsbr_domain_t *domain, int thread_count, void (*free_node)(qsbr_entry_t *entry))
+{
+    atomic_init(&domain->epoch, 1);
+    // Threads that have not started yet count as being at grace period 0,
+    // so nothing they might still reach can be freed before they report
+    domain->readers = aligned_alloc(QSBR_CACHE_LINE, thread_count * sizeof(qsbr_reader_t));
+    for (int th = 0; th < thread_count; th++)
+        atomic_init(&domain->readers[th].quiescent, 0);
+    domain->thread_count = thread_count;
+    atomic_init(&domain->next_id, 0);
+    domain->free_node = free_node;
+    domain->leftover = NULL;
+    pthread_mutex_init(&domain->leftover_mutex, NULL);
+}
+
+void qsbr_destroy(qsbr_domain_t *domain)
+{
+    // Every thread is offline, so all pending nodes can go
+    qsbr_entry_t *entry = domain->leftover;
+    while (entry != NULL)
+    {
+        qsbr_entry_t *next = entry->next;
+        domain->free_node(entry);
+        entry = next;
+    }
+    domain->leftover = NULL;
+
+    pthread_mutex_destroy(&domain->leftover_mutex);
+    free(domain->readers);
+    domain->readers = NULL;
+}
+
+void qsbr_thread_init(qsbr_thread_t *t, qsbr_domain_t *domain)
+{
+    t->domain = domain;
+    t->me = &domain->readers[atomic_fetch_add(&domain->next_id, 1)];
+    t->pending = NULL;
+    t->pending_count = 0;
+}
+
+void qsbr_retire(qsbr_thread_t *t, qsbr_entry_t *entry)
+{
+    // Readers may still be on the node: start a new grace period
+    entry->retire_epoch = atomic_fetch_add(&t->domain->epoch, 1) + 1;
+    entry->next = t->pending;
+    t->pending = entry;
+    t->pending_count++;
+}
+
+void qsbr_reclaim(qsbr_thread_t *t)
+{
+    qsbr_domain_t *domain = t->domain;
+    unsigned long min_seen = QSBR_OFFLINE;
+    for (int th = 0; th < domain->thread_count; th++)
+    {
+        unsigned long seen = atomic_load_explicit(&domain->readers[th].quiescent, memory_order_acquire);
+        if (seen < min_seen)
+            min_seen = seen;
+    }
+
+    qsbr_entry_t **link = &t->pending;
+    while (*link != NULL)
+    {
+        qsbr_entry_t *entry = *link;
+        if (entry->retire_epoch <= min_seen)
+        {
+            *link = entry->next;
+            domain->free_node(entry);
+            t->pending_count--;
+        }
+        else
+        {
+            link = &entry->next;
+        }
+    }
+}
+
+void qsbr_thread_offline(qsbr_thread_t *t)
+{
+    qsbr_domain_t *domain = t->domain;
+    atomic_store_explicit(&t->me->quiescent, QSBR_OFFLINE, memory_order_release);
+    qsbr_reclaim(t);
+    if (t->pending == NULL)
+        return;
+
+    qsbr_entry_t *last = t->pending;
+    while (last->next != NULL)
+        last = last->next;
+
+    pthread_mutex_lock(&domain->leftover_mutex);
+    last->next = domain->leftover;
+    domain->leftover = t->pending;
+    pthread_mutex_unlock(&domain->leftover_mutex);
+    t->pending = NULL;
+    t->pending_count = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef QSBR_H
+#define QSBR_H
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Quiescent-state-based reclamation (QSBR) for the RCU, lazy and skip
+// lists. A node a writer has unlinked is tagged with a new grace-period
+// number and freed once every thread has announced a quiescent state at
+// or after that number. Each thread announces one between operations,
+// when it holds no pointer into the structure, by writing its own cache
+// line.
+
+#define QSBR_CACHE_LINE 64
+#define QSBR_RECLAIM_BATCH 32  // try to reclaim once this many nodes are pending
+#define QSBR_OFFLINE ULONG_MAX // quiescent value of a thread that has finished
+
+// Embedded in every node that can be retired
+typedef struct qsbr_entry_s
+{
+    unsigned long retire_epoch; // grace period that must end before freeing
+    struct qsbr_entry_s *next;  // chain of nodes awaiting a grace period
+} qsbr_entry_t;
+
+// Last grace period a thread has seen outside any operation
+typedef struct
+{
+    _Atomic unsigned long quiescent;
+    char pad[QSBR_CACHE_LINE - sizeof(unsigned long)];
+} qsbr_reader_t;
+
+// Grace periods and reader slots of one run
+typedef struct
+{
+    _Atomic unsigned long epoch; // current grace period
+    qsbr_reader_t *readers;      // thread_count records
+    int thread_count;
+    atomic_int next_id;
+    void (*free_node)(qsbr_entry_t *entry); // frees the node holding entry
+    qsbr_entry_t *leftover;                 // pending nodes of finished threads
+    pthread_mutex_t leftover_mutex;
+} qsbr_domain_t;
+
+// A worker's reader slot and the nodes it has retired
+typedef struct
+{
+    qsbr_domain_t *domain;
+    qsbr_reader_t *me;
+    qsbr_entry_t *pending;
+    int pending_count;
+} qsbr_thread_t;
+
+// Set up a domain for thread_count workers, and free whatever is still
+// pending once every worker is offline
+void qsbr_init(qsbr_domain_t *domain, int thread_count, void (*free_node)(qsbr_entry_t *entry));
+void qsbr_destroy(qsbr_domain_t *domain);
+
+// Give the calling worker the next reader slot
+void qsbr_thread_init(qsbr_thread_t *t, qsbr_domain_t *domain);
+
+// Defer freeing a node the caller has just unlinked
+void qsbr_retire(qsbr_thread_t *t, qsbr_entry_t *entry);
+
+// Free pending nodes whose grace period every thread has passed
+void qsbr_reclaim(qsbr_thread_t *t);
+
+// Between operations: nothing this thread saw before is still in use.
+// Reclaims once a batch of nodes is pending.
+static inline void qsbr_quiescent_state(qsbr_thread_t *t)
+{
+    unsigned long epoch = atomic_load_explicit(&t->domain->epoch, memory_order_acquire);
+    atomic_store_explicit(&t->me->quiescent, epoch, memory_order_release);
+    if (t->pending_count >= QSBR_RECLAIM_BATCH)
+        qsbr_reclaim(t);
+}
+
+// After the last operation: go offline so nobody waits on this thread,
+// then hand what is still pending to the domain
+void qsbr_thread_offline(qsbr_thread_t *t);
+
+#endif
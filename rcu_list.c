@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "qsbr.h"
+
+// RCU-style list using quiescent-state-based reclamation (qsbr.c).
+// Member runs with no locks and no shared writes; Insert/Delete serialize
+// on one writer mutex and publish with release stores. A deleted node is
+// retired and freed once every thread has passed a quiescent state; each
+// thread announces one after every operation.
+
+struct rcu_node_s
+{
+    int data;
+    _Atomic(struct rcu_node_s *) next;
+    qsbr_entry_t retire; // grace period and chain while awaiting free
+};
+
+typedef struct
+{
+    struct rcu_node_s *head; // INT_MIN sentinel
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    pthread_mutex_t writer_mutex;
+    qsbr_domain_t qsbr;
+} thread_params_t;
+
+static struct rcu_node_s *rcu_new_node(int value, struct rcu_node_s *next)
+{
+    struct rcu_node_s *node = malloc(sizeof(struct rcu_node_s));
+    node->data = value;
+    atomic_init(&node->next, next);
+    return node;
+}
+
+static void rcu_free_entry(qsbr_entry_t *entry)
+{
+    free((char *)entry - offsetof(struct rcu_node_s, retire));
+}
+
+static int rcu_member(int value, struct rcu_node_s *head)
+{
+    struct rcu_node_s *curr_p = atomic_load_explicit(&head->next, memory_order_acquire);
+    while (curr_p != NULL && curr_p->data < value)
+        curr_p = atomic_load_explicit(&curr_p->next, memory_order_acquire);
+
+    return curr_p != NULL && curr_p->data == value;
+}
+
+// Writers hold writer_mutex, so plain traversal is safe for them
+static int rcu_insert(int value, struct rcu_node_s *head)
+{
+    struct rcu_node_s *pred_p = head;
+    struct rcu_node_s *curr_p = atomic_load_explicit(&pred_p->next, memory_order_relaxed);
+    while (curr_p != NULL && curr_p->data < value)
+    {
+        pred_p = curr_p;
+        curr_p = atomic_load_explicit(&curr_p->next, memory_order_relaxed);
+    }
+
+    if (curr_p != NULL && curr_p->data == value)
+        return 0;
+
+    // Fully initialise the node before readers can see it
+    struct rcu_node_s *temp_p = rcu_new_node(value, curr_p);
+    atomic_store_explicit(&pred_p->next, temp_p, memory_order_release);
+    return 1;
+}
+
+static int rcu_delete(qsbr_thread_t *t, int value, struct rcu_node_s *head)
+{
+    struct rcu_node_s *pred_p = head;
+    struct rcu_node_s *curr_p = atomic_load_explicit(&pred_p->next, memory_order_relaxed);
+    while (curr_p != NULL && curr_p->data < value)
+    {
+        pred_p = curr_p;
+        curr_p = atomic_load_explicit(&curr_p->next, memory_order_relaxed);
+    }
+
+    if (curr_p == NULL || curr_p->data != value)
+        return 0;
+
+    atomic_store_explicit(&pred_p->next,
+                          atomic_load_explicit(&curr_p->next, memory_order_relaxed),
+                          memory_order_release);
+
+    // Readers may still be on curr: defer the free
+    qsbr_retire(t, &curr_p->retire);
+    return 1;
+}
+
+// Copy the (already sorted) initial list behind the sentinel
+static struct rcu_node_s *rcu_build(struct list_node_s *head_p)
+{
+    struct rcu_node_s *head = rcu_new_node(INT_MIN, NULL);
+    struct rcu_node_s *tail = head;
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        struct rcu_node_s *node = rcu_new_node(curr_p->data, NULL);
+        atomic_store_explicit(&tail->next, node, memory_order_relaxed);
+        tail = node;
+    }
+    return head;
+}
+
+static void rcu_destroy(struct rcu_node_s *head)
+{
+    struct rcu_node_s *curr_p = head;
+    while (curr_p != NULL)
+    {
+        struct rcu_node_s *next = atomic_load_explicit(&curr_p->next, memory_order_relaxed);
+        free(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    qsbr_thread_t self;
+    qsbr_thread_init(&self, &params->qsbr);
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations; readers never lock
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+        {
+            pthread_mutex_lock(&params->writer_mutex);
+            rcu_insert(val, params->head);
+            pthread_mutex_unlock(&params->writer_mutex);
+        }
+        else if (op == 1)
+        {
+            pthread_mutex_lock(&params->writer_mutex);
+            rcu_delete(&self, val, params->head);
+            pthread_mutex_unlock(&params->writer_mutex);
+        }
+        else
+        {
+            rcu_member(val, params->head);
+        }
+
+        qsbr_quiescent_state(&self);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    qsbr_thread_offline(&self);
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_rcu(struct list_node_s **list_head,
+                       int m,
+                       double mMember,
+                       double mInsert,
+                       double mDelete,
+                       int thread_count,
+                       int program_type)
+{
+    if (program_type != 9) // 9 = RCU list version
+    {
+        fprintf(stderr, "Only RCU list version (program_type=9) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    // Convert the initial list outside the timed region
+    struct rcu_node_s *head = rcu_build(*list_head);
+
+    thread_params_t params = {head, m, mMember, mInsert, mDelete, thread_count};
+    pthread_mutex_init(&params.writer_mutex, NULL);
+    qsbr_init(&params.qsbr, thread_count, rcu_free_entry);
+
+    printf("Running in RCU list mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    qsbr_destroy(&params.qsbr);
+
+    // Free both lists
+    rcu_destroy(head);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+    pthread_mutex_destroy(&params.writer_mutex);
+
+    return elapsed_time;
+}
@@ -4,12 +4,47 @@
 
 #include "linkedlist.h"
 
-double run_threads(struct list_node_s **list_head,
-                   int m,
-                   double mMember,
-                   double mInsert,
-                   double mDelete,
-                   int thread_count,
-                   int program_type);
+// Keys are drawn uniformly from [0, key_range); set by main.c
+extern int key_range;
+
+// Number of key-range shards used by the sharded version; set by main.c
+extern int shard_count;
+
+// Jain's fairness index of per-thread throughput for the last run
+// (1 = perfectly fair); versions that don't measure it leave it at 0
+extern double run_fairness;
+
+// Operations the lock-based list versions sort and apply per lock
+// acquisition with ApplyBatch; 1 keeps the one-lock-per-operation loop
+extern int batch_size;
+
+// Every list implementation runs one experiment through this signature
+// and returns the elapsed time in microseconds
+typedef double run_threads_fn(struct list_node_s **list_head,
+                              int m,
+                              double mMember,
+                              double mInsert,
+                              double mDelete,
+                              int thread_count,
+                              int program_type);
+
+run_threads_fn run_threads_serial, run_threads_mutex, run_threads_rwlock,
+    run_threads_hoh, run_threads_lazy, run_threads_lockfree, run_threads_skiplist,
+    run_threads_unrolled, run_threads_sharded, run_threads_rcu, run_threads_drwlock,
+    run_threads_fc, run_threads_blink, run_threads_hash;
+
+// Registry of the implementations, indexed by program_type (backends.c)
+struct list_backend_s
+{
+    const char *name;  // selects it on the command line (--impl=NAME)
+    const char *label; // ProgramType column of the CSV
+    run_threads_fn *run_threads;
+};
+
+extern const struct list_backend_s list_backends[];
+extern const int num_list_backends;
+
+// program_type of the backend called name, or -1
+int find_backend(const char *name);
 
 #endif
@@ -5,6 +5,40 @@
 #include <pthread.h>
 #include <pthread.h>
 #include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "lock_stats.h"
+
+// The same worker loop is built twice: on glibc's pthread_rwlock_t as
+// run_threads_rwlock and, with -DUSE_DIST_RWLOCK, on the per-slot
+// distributed lock as run_threads_drwlock
+#ifdef USE_DIST_RWLOCK
+#include "dist_rwlock.h"
+typedef dist_rwlock_t list_rwlock_t;
+#define list_rwlock_init(l) dist_rwlock_init(l)
+#define list_rwlock_rdlock(l) dist_rwlock_rdlock(l)
+#define list_rwlock_rdunlock(l) dist_rwlock_rdunlock(l)
+#define list_rwlock_wrlock(l) dist_rwlock_wrlock(l)
+#define list_rwlock_wrunlock(l) dist_rwlock_wrunlock(l)
+#define list_rwlock_destroy(l) dist_rwlock_destroy(l)
+#define RWLOCK_PROGRAM_TYPE 10
+#define RWLOCK_RUN_THREADS run_threads_drwlock
+#define RWLOCK_MODE_NAME "distributed read-write lock"
+#else
+typedef pthread_rwlock_t list_rwlock_t;
+#define list_rwlock_init(l) pthread_rwlock_init(l, NULL)
+#define list_rwlock_rdlock(l) pthread_rwlock_rdlock(l)
+#define list_rwlock_rdunlock(l) pthread_rwlock_unlock(l)
+#define list_rwlock_wrlock(l) pthread_rwlock_wrlock(l)
+#define list_rwlock_wrunlock(l) pthread_rwlock_unlock(l)
+#define list_rwlock_destroy(l) pthread_rwlock_destroy(l)
+#define RWLOCK_PROGRAM_TYPE 2
+#define RWLOCK_RUN_THREADS run_threads_rwlock
+#define RWLOCK_MODE_NAME "read-write lock"
+#endif
 
 typedef struct
 {
@@ -12,115 +46,148 @@ typedef struct
     int m;
     double mMember, mInsert, mDelete;
     int thread_count;
-    pthread_rwlock_t *rwlock;
+    list_rwlock_t *rwlock;
 } thread_params_t;
 
-void *thread_worker(void *args)
+static void *thread_worker(void *args)
 {
     thread_params_t *params = (thread_params_t *)args;
 
-    // Thread-local RNG seed
-    unsigned int seed = time(NULL) ^ (unsigned long)pthread_self();
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
 
-    // Calculate exact number of operations per thread
-    int Mem = (int)(params->mMember * params->m / params->thread_count);
-    int Ins = (int)(params->mInsert * params->m / params->thread_count);
-    int Del = (int)(params->mDelete * params->m / params->thread_count);
-    int totalOps = Mem + Ins + Del;
+    LOCK_STATS_DECLARE(lock_stats);
 
-    // Step 1: Create an array with exact operations
-    int *ops = malloc(totalOps * sizeof(int));
-    int idx = 0;
-    for (int i = 0; i < Mem; i++) ops[idx++] = 2;  // Member
-    for (int i = 0; i < Ins; i++) ops[idx++] = 0;  // Insert
-    for (int i = 0; i < Del; i++) ops[idx++] = 1;  // Delete
-
-    // Step 2: Shuffle operations array (Fisher-Yates)
-    for (int i = totalOps - 1; i > 0; i--)
-    {
-        int j = rand_r(&seed) % (i + 1);
-        int tmp = ops[i];
-        ops[i] = ops[j];
-        ops[j] = tmp;
-    }
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
 
     // Step 3: Execute operations with correct locks
-    for (int i = 0; i < totalOps; i++)
+    if (batch_size > 1)
     {
-        int val = rand_r(&seed) % 65536;
-
-        if (ops[i] == 0)
-        {
-            // Insert (write lock)
-            pthread_rwlock_wrlock(params->rwlock);
-            Insert(val, params->head);
-            pthread_rwlock_unlock(params->rwlock);
-        }
-        else if (ops[i] == 1)
+        // A batch of only Member calls can share the read lock
+        struct list_op_s *batch = malloc(batch_size * sizeof(struct list_op_s));
+        for (int i = 0; duration_more_ops(&i, totalOps, batch_size); i += batch_size)
         {
-            // Delete (write lock)
-            pthread_rwlock_wrlock(params->rwlock);
-            Delete(val, params->head);
-            pthread_rwlock_unlock(params->rwlock);
+            int count = totalOps - i < batch_size ? totalOps - i : batch_size;
+            int writes = 0;
+            for (int j = 0; j < count; j++)
+            {
+                batch[j].op = TRACE_OP(ops[i + j]);
+                batch[j].value = TRACE_KEY(ops[i + j]);
+                writes |= batch[j].op != LIST_OP_MEMBER;
+            }
+            uint64_t op_start = latency_start();
+            SortBatch(batch, count);
+
+            if (writes)
+            {
+                LOCK_STATS_WAIT(lock_stats);
+                list_rwlock_wrlock(params->rwlock);
+                LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_WRITE);
+                ApplyBatch(batch, count, params->head);
+                LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_WRITE);
+                list_rwlock_wrunlock(params->rwlock);
+            }
+            else
+            {
+                LOCK_STATS_WAIT(lock_stats);
+                list_rwlock_rdlock(params->rwlock);
+                LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_READ);
+                ApplyBatch(batch, count, params->head);
+                LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_READ);
+                list_rwlock_rdunlock(params->rwlock);
+            }
+
+            latency_record_batch(batch, count, op_start);
         }
-        else
+        free(batch);
+    }
+    else
+    {
+        for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
         {
-            // Member (read lock)
-            pthread_rwlock_rdlock(params->rwlock);
-            Member(val, *(params->head));
-            pthread_rwlock_unlock(params->rwlock);
+            int op = TRACE_OP(ops[i]);
+            int val = TRACE_KEY(ops[i]);
+            uint64_t op_start = latency_start();
+
+            if (op == 0)
+            {
+                // Insert (write lock)
+                LOCK_STATS_WAIT(lock_stats);
+                list_rwlock_wrlock(params->rwlock);
+                LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_WRITE);
+                Insert(val, params->head);
+                LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_WRITE);
+                list_rwlock_wrunlock(params->rwlock);
+            }
+            else if (op == 1)
+            {
+                // Delete (write lock)
+                LOCK_STATS_WAIT(lock_stats);
+                list_rwlock_wrlock(params->rwlock);
+                LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_WRITE);
+                Delete(val, params->head);
+                LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_WRITE);
+                list_rwlock_wrunlock(params->rwlock);
+            }
+            else
+            {
+                // Member (read lock)
+                LOCK_STATS_WAIT(lock_stats);
+                list_rwlock_rdlock(params->rwlock);
+                LOCK_STATS_ACQUIRED(lock_stats, LOCK_STATS_READ);
+                Member(val, *(params->head));
+                LOCK_STATS_RELEASE(lock_stats, LOCK_STATS_READ);
+                list_rwlock_rdunlock(params->rwlock);
+            }
+
+            latency_record(op, op_start);
         }
     }
+    thread_pool_end_ops();
+    LOCK_STATS_PUBLISH(lock_stats);
 
-    free(ops);
+    op_stream_close(&stream);
     return NULL;
 }
 
-double run_threads(struct list_node_s **list_head,
-                   int m,
-                   double mMember,
-                   double mInsert,
-                   double mDelete,
-                   int thread_count,
-                   int program_type)
+double RWLOCK_RUN_THREADS(struct list_node_s **list_head,
+                          int m,
+                          double mMember,
+                          double mInsert,
+                          double mDelete,
+                          int thread_count,
+                          int program_type)
 {
-    if (program_type != 2) // 2 = read-write lock version
+    if (program_type != RWLOCK_PROGRAM_TYPE) // 2 = read-write lock, 10 = distributed read-write lock
     {
-        fprintf(stderr, "Only read-write lock version (program_type=2) is implemented in this function.\n");
+        fprintf(stderr, "Only " RWLOCK_MODE_NAME " version (program_type=%d) is implemented in this function.\n",
+                RWLOCK_PROGRAM_TYPE);
         exit(EXIT_FAILURE);
     }
     srand(time(NULL)); // random seed
 
-    pthread_t *threads = malloc(thread_count * sizeof(pthread_t));
-    pthread_rwlock_t rwlock;
-    pthread_rwlock_init(&rwlock, NULL);
+    list_rwlock_t rwlock;
+    list_rwlock_init(&rwlock);
 
     thread_params_t params = {list_head, m, mMember, mInsert, mDelete,
                               thread_count, &rwlock};
 
     // double start = get_time();
 
-    printf("Running in read-write lock mode with %d threads and %d operations\n", thread_count, m);
-    // Start timing
-    struct timeval start, stop;
-    gettimeofday(&start, NULL);
-
-    for (long i = 0; i < thread_count; i++)
-        pthread_create(&threads[i], NULL, thread_worker, &params);
-
-    for (int i = 0; i < thread_count; i++)
-        pthread_join(threads[i], NULL);
-
-// Stop timing
-    gettimeofday(&stop, NULL);
-    unsigned long elapsed_time = (stop.tv_sec - start.tv_sec) * 1000000 +
-                                 stop.tv_usec - start.tv_usec;
+    printf("Running in " RWLOCK_MODE_NAME " mode (batch %d) with %d threads and %d operations\n",
+           batch_size, thread_count, m);
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
 
     // Free the list
     destructor(*list_head); // free all nodes
     *list_head = NULL;
-    pthread_rwlock_destroy(&rwlock);
-    free(threads);
+    list_rwlock_destroy(&rwlock);
 
     return elapsed_time;
 }
@@ -3,17 +3,20 @@
 #include <time.h>
 #include <sys/time.h>
 #include "linkedlist.h"
+#include "run_threads.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "perf_counters.h"
 
-#define MAX_VALUE 65536 // 2^16
 
-
-double run_threads(struct list_node_s **list_head,
-                   int m,
-                   double mMember,
-                   double mInsert,
-                   double mDelete,
-                   int thread_count,
-                   int program_type)
+double run_threads_serial(struct list_node_s **list_head,
+                          int m,
+                          double mMember,
+                          double mInsert,
+                          double mDelete,
+                          int thread_count,
+                          int program_type)
 {
     if (program_type != 0)
     {
@@ -23,59 +26,44 @@ double run_threads(struct list_node_s **list_head,
 
     srand(time(NULL)); // random seed
 
-    // Calculate exact counts
-    int Mem = (int)(m * mMember);
-    int Ins = (int)(m * mInsert);
-    int Del = m - Mem - Ins;
-
-    // Operation counters
-    int insOps = 0;
-    int memOps = 0;
-    int delOps = 0;
-    int totOps = 0;
-    printf("Running in serial mode with %d operations\n", m);
+    // The single thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, 0, m, mMember, mInsert, mDelete, 1);
+    printf("Running in serial mode with %d operations\n", stream.count);
 
     // Start timing
     struct timeval start, stop;
+    perf_counters_begin();
     gettimeofday(&start, NULL);
+    duration_ops_started();
 
-    // Perform m operations
-    while (totOps < m)
+    // Perform m operations, or cycle through them for --duration seconds
+    for (int i = 0; duration_more_ops(&i, stream.count, 1); i++)
     {
-        int rand_value = rand() % MAX_VALUE;
-        int op = rand() % 3;
+        int op = TRACE_OP(stream.ops[i]);
+        int value = TRACE_KEY(stream.ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == LIST_OP_INSERT)
+            Insert(value, list_head);
+        else if (op == LIST_OP_DELETE)
+            Delete(value, list_head);
+        else
+            Member(value, *list_head);
 
-        if (op == 0 && insOps < Ins)
-        {
-            // Insert operation
-            Insert(rand_value, list_head);
-            insOps++;
-            totOps++;
-        }
-        else if (op == 1 && delOps < Del)
-        {
-            // Delete operation
-            Delete(rand_value, list_head);
-            delOps++;
-            totOps++;
-        }
-        else if (memOps < Mem)
-        {
-            // Member operation
-            Member(rand_value, *list_head);
-            memOps++;
-            totOps++;
-        }
+        latency_record(op, op_start);
     }
 
     // Stop timing
     gettimeofday(&stop, NULL);
+    perf_counters_end();
     unsigned long elapsed_time = (stop.tv_sec - start.tv_sec) * 1000000 +
                                  stop.tv_usec - start.tv_usec;
 
     // Free the list
     destructor(*list_head); // free all nodes
     *list_head = NULL;
+    op_stream_close(&stream);
 
     return elapsed_time;
 }
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+// Key-range sharded list: [0, key_range) is split into shard_count equal
+// ranges, each an ordinary sorted list from linkedlist.c behind its own
+// read-write lock. An operation locks only its shard and walks a list
+// about 1/shard_count as long.
+
+#define CACHE_LINE 64
+
+// One shard per cache line so neighbouring locks don't false-share
+typedef struct
+{
+    pthread_rwlock_t rwlock;
+    struct list_node_s *head;
+} __attribute__((aligned(CACHE_LINE))) shard_t;
+
+typedef struct
+{
+    shard_t *shards;
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+} thread_params_t;
+
+static inline shard_t *shard_for(shard_t *shards, int value)
+{
+    return &shards[(long)value * shard_count / key_range];
+}
+
+// Move the nodes of the (sorted) initial list into their shards
+static void shards_split(shard_t *shards, struct list_node_s *head_p)
+{
+    struct list_node_s *tails[shard_count];
+    for (int s = 0; s < shard_count; s++)
+        tails[s] = NULL;
+
+    struct list_node_s *curr_p = head_p;
+    while (curr_p != NULL)
+    {
+        struct list_node_s *next = curr_p->next;
+        int s = (int)((long)curr_p->data * shard_count / key_range);
+        curr_p->next = NULL;
+        if (tails[s] == NULL)
+            shards[s].head = curr_p;
+        else
+            tails[s]->next = curr_p;
+        tails[s] = curr_p;
+        curr_p = next;
+    }
+}
+
+// Chain the shards back into one sorted list
+static struct list_node_s *shards_join(shard_t *shards)
+{
+    struct list_node_s *head_p = NULL;
+    struct list_node_s *tail_p = NULL;
+    for (int s = 0; s < shard_count; s++)
+    {
+        if (shards[s].head == NULL)
+            continue;
+        if (tail_p == NULL)
+            head_p = shards[s].head;
+        else
+            tail_p->next = shards[s].head;
+        tail_p = shards[s].head;
+        while (tail_p->next != NULL)
+            tail_p = tail_p->next;
+    }
+    return head_p;
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, locking only the key's shard
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+        shard_t *shard = shard_for(params->shards, val);
+
+        if (op == 0)
+        {
+            pthread_rwlock_wrlock(&shard->rwlock);
+            Insert(val, &shard->head);
+            pthread_rwlock_unlock(&shard->rwlock);
+        }
+        else if (op == 1)
+        {
+            pthread_rwlock_wrlock(&shard->rwlock);
+            Delete(val, &shard->head);
+            pthread_rwlock_unlock(&shard->rwlock);
+        }
+        else
+        {
+            pthread_rwlock_rdlock(&shard->rwlock);
+            Member(val, shard->head);
+            pthread_rwlock_unlock(&shard->rwlock);
+        }
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_sharded(struct list_node_s **list_head,
+                           int m,
+                           double mMember,
+                           double mInsert,
+                           double mDelete,
+                           int thread_count,
+                           int program_type)
+{
+    if (program_type != 8) // 8 = sharded list version
+    {
+        fprintf(stderr, "Only sharded list version (program_type=8) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    shard_t *shards = aligned_alloc(CACHE_LINE, shard_count * sizeof(shard_t));
+    for (int s = 0; s < shard_count; s++)
+    {
+        pthread_rwlock_init(&shards[s].rwlock, NULL);
+        shards[s].head = NULL;
+    }
+
+    // Distribute the initial list outside the timed region
+    shards_split(shards, *list_head);
+    *list_head = NULL;
+
+    thread_params_t params = {shards, m, mMember, mInsert, mDelete, thread_count};
+
+    printf("Running in sharded list mode with %d shards, %d threads and %d operations\n",
+           shard_count, thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // Free the list
+    *list_head = shards_join(shards);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    for (int s = 0; s < shard_count; s++)
+        pthread_rwlock_destroy(&shards[s].rwlock);
+    free(shards);
+
+    return elapsed_time;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+#include "qsbr.h"
+
+// Lazy concurrent skip list (Herlihy, Lev, Luchangco, Shavit).
+// Member is wait-free and takes no locks; Insert/Delete lock only the
+// predecessors at each level they touch and validate before linking.
+// Unlinked nodes are retired to qsbr.c and freed during the run.
+
+#define MAX_LEVEL 24 // enough for 2^24 keys with p = 1/2
+
+struct skip_node_s
+{
+    int data;
+    int top_level;             // number of levels this node is linked at
+    atomic_int marked;         // logically deleted
+    atomic_int fully_linked;   // linked at every level
+    pthread_mutex_t mutex;
+    qsbr_entry_t retire;       // grace period and chain while awaiting free
+    _Atomic(struct skip_node_s *) next[]; // top_level forward pointers
+};
+
+typedef struct
+{
+    struct skip_node_s *head; // INT_MIN sentinel at every level
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    qsbr_domain_t qsbr;
+} thread_params_t;
+
+static struct skip_node_s *skip_new_node(int value, int top_level)
+{
+    struct skip_node_s *node = malloc(sizeof(struct skip_node_s) +
+                                      top_level * sizeof(struct skip_node_s *));
+    node->data = value;
+    node->top_level = top_level;
+    atomic_init(&node->marked, 0);
+    atomic_init(&node->fully_linked, 0);
+    pthread_mutex_init(&node->mutex, NULL);
+    for (int level = 0; level < top_level; level++)
+        atomic_init(&node->next[level], NULL);
+    return node;
+}
+
+static void skip_free_node(struct skip_node_s *node)
+{
+    pthread_mutex_destroy(&node->mutex);
+    free(node);
+}
+
+static void skip_free_entry(qsbr_entry_t *entry)
+{
+    skip_free_node((struct skip_node_s *)((char *)entry - offsetof(struct skip_node_s, retire)));
+}
+
+// Geometric level distribution with p = 1/2
+static int skip_random_level(unsigned int *seed)
+{
+    int level = 1;
+    while (level < MAX_LEVEL && (rand_r(seed) & 1))
+        level++;
+    return level;
+}
+
+// Fill preds/succs at every level; returns the highest level at which
+// value was found, or -1
+static int skip_find(int value, struct skip_node_s *head,
+                     struct skip_node_s **preds, struct skip_node_s **succs)
+{
+    int level_found = -1;
+    struct skip_node_s *pred_p = head;
+    for (int level = MAX_LEVEL - 1; level >= 0; level--)
+    {
+        struct skip_node_s *curr_p = atomic_load_explicit(&pred_p->next[level], memory_order_acquire);
+        while (value > curr_p->data)
+        {
+            pred_p = curr_p;
+            curr_p = atomic_load_explicit(&pred_p->next[level], memory_order_acquire);
+        }
+        if (level_found == -1 && value == curr_p->data)
+            level_found = level;
+        preds[level] = pred_p;
+        succs[level] = curr_p;
+    }
+    return level_found;
+}
+
+// Unlock each distinct predecessor in preds[0..highest_locked]
+static void skip_unlock_preds(struct skip_node_s **preds, int highest_locked)
+{
+    for (int level = 0; level <= highest_locked; level++)
+        if (level == 0 || preds[level] != preds[level - 1])
+            pthread_mutex_unlock(&preds[level]->mutex);
+}
+
+static int skip_member(int value, struct skip_node_s *head)
+{
+    struct skip_node_s *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+    int level_found = skip_find(value, head, preds, succs);
+    return level_found != -1 &&
+           atomic_load_explicit(&succs[level_found]->fully_linked, memory_order_acquire) &&
+           !atomic_load_explicit(&succs[level_found]->marked, memory_order_acquire);
+}
+
+static int skip_insert(int value, struct skip_node_s *head, unsigned int *seed)
+{
+    int top_level = skip_random_level(seed);
+    struct skip_node_s *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+
+    while (1)
+    {
+        int level_found = skip_find(value, head, preds, succs);
+        if (level_found != -1)
+        {
+            struct skip_node_s *found_p = succs[level_found];
+            if (!atomic_load_explicit(&found_p->marked, memory_order_acquire))
+            {
+                // Wait for a concurrent insert of the same value to finish
+                while (!atomic_load_explicit(&found_p->fully_linked, memory_order_acquire))
+                    ;
+                return 0;
+            }
+            continue; // being deleted, retry
+        }
+
+        // Lock predecessors bottom-up and validate
+        int highest_locked = -1;
+        int valid = 1;
+        struct skip_node_s *prev_pred = NULL;
+        for (int level = 0; valid && level < top_level; level++)
+        {
+            struct skip_node_s *pred_p = preds[level];
+            struct skip_node_s *succ_p = succs[level];
+            if (pred_p != prev_pred)
+            {
+                pthread_mutex_lock(&pred_p->mutex);
+                highest_locked = level;
+                prev_pred = pred_p;
+            }
+            valid = !atomic_load_explicit(&pred_p->marked, memory_order_relaxed) &&
+                    !atomic_load_explicit(&succ_p->marked, memory_order_relaxed) &&
+                    atomic_load_explicit(&pred_p->next[level], memory_order_relaxed) == succ_p;
+        }
+        if (!valid)
+        {
+            skip_unlock_preds(preds, highest_locked);
+            continue;
+        }
+
+        struct skip_node_s *temp_p = skip_new_node(value, top_level);
+        for (int level = 0; level < top_level; level++)
+            atomic_init(&temp_p->next[level], succs[level]);
+        for (int level = 0; level < top_level; level++)
+            atomic_store_explicit(&preds[level]->next[level], temp_p, memory_order_release);
+        atomic_store_explicit(&temp_p->fully_linked, 1, memory_order_release);
+
+        skip_unlock_preds(preds, highest_locked);
+        return 1;
+    }
+}
+
+static int skip_delete(qsbr_thread_t *t, int value, struct skip_node_s *head)
+{
+    struct skip_node_s *victim = NULL;
+    int is_marked = 0;
+    int top_level = -1;
+    struct skip_node_s *preds[MAX_LEVEL], *succs[MAX_LEVEL];
+
+    while (1)
+    {
+        int level_found = skip_find(value, head, preds, succs);
+        if (!is_marked)
+        {
+            // Only delete a fully linked node found at its own top level
+            if (level_found == -1)
+                return 0;
+            victim = succs[level_found];
+            if (!atomic_load_explicit(&victim->fully_linked, memory_order_acquire) ||
+                victim->top_level - 1 != level_found ||
+                atomic_load_explicit(&victim->marked, memory_order_acquire))
+                return 0;
+
+            top_level = victim->top_level;
+            pthread_mutex_lock(&victim->mutex);
+            if (atomic_load_explicit(&victim->marked, memory_order_relaxed))
+            {
+                pthread_mutex_unlock(&victim->mutex);
+                return 0;
+            }
+            atomic_store_explicit(&victim->marked, 1, memory_order_release);
+            is_marked = 1;
+        }
+
+        // Lock predecessors bottom-up and validate
+        int highest_locked = -1;
+        int valid = 1;
+        struct skip_node_s *prev_pred = NULL;
+        for (int level = 0; valid && level < top_level; level++)
+        {
+            struct skip_node_s *pred_p = preds[level];
+            if (pred_p != prev_pred)
+            {
+                pthread_mutex_lock(&pred_p->mutex);
+                highest_locked = level;
+                prev_pred = pred_p;
+            }
+            valid = !atomic_load_explicit(&pred_p->marked, memory_order_relaxed) &&
+                    atomic_load_explicit(&pred_p->next[level], memory_order_relaxed) == victim;
+        }
+        if (!valid)
+        {
+            skip_unlock_preds(preds, highest_locked);
+            continue;
+        }
+
+        for (int level = top_level - 1; level >= 0; level--)
+            atomic_store_explicit(&preds[level]->next[level],
+                                  atomic_load_explicit(&victim->next[level], memory_order_relaxed),
+                                  memory_order_release);
+        pthread_mutex_unlock(&victim->mutex);
+        skip_unlock_preds(preds, highest_locked);
+
+        // Readers may still be standing on victim: defer the free
+        qsbr_retire(t, &victim->retire);
+        return 1;
+    }
+}
+
+// Build the skip list from the (already sorted) initial list in one pass
+static struct skip_node_s *skip_build(struct list_node_s *head_p, unsigned int *seed)
+{
+    struct skip_node_s *head = skip_new_node(INT_MIN, MAX_LEVEL);
+    struct skip_node_s *tail = skip_new_node(INT_MAX, MAX_LEVEL);
+    struct skip_node_s *last[MAX_LEVEL];
+    for (int level = 0; level < MAX_LEVEL; level++)
+        last[level] = head;
+
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        struct skip_node_s *node = skip_new_node(curr_p->data, skip_random_level(seed));
+        for (int level = 0; level < node->top_level; level++)
+        {
+            atomic_store_explicit(&last[level]->next[level], node, memory_order_relaxed);
+            last[level] = node;
+        }
+        atomic_store_explicit(&node->fully_linked, 1, memory_order_relaxed);
+    }
+
+    for (int level = 0; level < MAX_LEVEL; level++)
+        atomic_store_explicit(&last[level]->next[level], tail, memory_order_relaxed);
+    atomic_store_explicit(&head->fully_linked, 1, memory_order_relaxed);
+    atomic_store_explicit(&tail->fully_linked, 1, memory_order_relaxed);
+    return head;
+}
+
+static void skip_destroy(struct skip_node_s *head)
+{
+    struct skip_node_s *curr_p = head;
+    while (curr_p != NULL)
+    {
+        struct skip_node_s *next = atomic_load_explicit(&curr_p->next[0], memory_order_relaxed);
+        skip_free_node(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    qsbr_thread_t self;
+    qsbr_thread_init(&self, &params->qsbr);
+
+    // Thread-local RNG seed for the levels of inserted nodes
+    unsigned int seed = time(NULL) ^ (unsigned long)pthread_self();
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations, readers never lock
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+            skip_insert(val, params->head, &seed);
+        else if (op == 1)
+            skip_delete(&self, val, params->head);
+        else
+            skip_member(val, params->head);
+
+        qsbr_quiescent_state(&self);
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    qsbr_thread_offline(&self);
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_skiplist(struct list_node_s **list_head,
+                            int m,
+                            double mMember,
+                            double mInsert,
+                            double mDelete,
+                            int thread_count,
+                            int program_type)
+{
+    if (program_type != 6) // 6 = skip list version
+    {
+        fprintf(stderr, "Only skip list version (program_type=6) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    // Convert the initial list outside the timed region
+    unsigned int build_seed = rand();
+    struct skip_node_s *head = skip_build(*list_head, &build_seed);
+
+    thread_params_t params = {head, m, mMember, mInsert, mDelete, thread_count};
+    qsbr_init(&params.qsbr, thread_count, skip_free_entry);
+
+    printf("Running in skip list mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    qsbr_destroy(&params.qsbr);
+
+    // Free both lists
+    skip_destroy(head);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+
+    return elapsed_time;
+}
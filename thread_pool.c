@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "thread_pool.h"
+#include "perf_counters.h"
+#include "affinity.h"
+#include "duration.h"
+
+double pool_start_skew = 0;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER; // a run was dispatched or the pool stops
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER; // the last worker of a run finished
+static pthread_t *pool_threads = NULL;
+static int pool_size = 0;
+static int pool_capacity = 0;
+static int stopping = 0;
+
+// Current run; written by thread_pool_run while every worker is idle
+static void *(*run_worker)(void *) = NULL;
+static void *run_arg = NULL;
+static int run_count = 0;               // workers taking part
+static int run_finished = 0;
+static unsigned long run_generation = 0; // bumped once per run
+static pthread_barrier_t ops_barrier;
+
+// Per worker, indexed by pool id
+static unsigned long *served = NULL; // last run generation the worker picked up
+static double *wake_us = NULL;       // when it picked up the current run
+static double *begin_us = NULL;      // when it reached its operation loop
+static double *end_us = NULL;        // when it left its operation loop
+
+static __thread int pool_id = -1;
+
+static double now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static void *pool_thread(void *args)
+{
+    pool_id = (int)(long)args;
+    affinity_pin_thread(pool_id); // worker pool_id always runs on the same CPU
+
+    pthread_mutex_lock(&pool_mutex);
+    for (;;)
+    {
+        while (!stopping && (pool_id >= run_count || served[pool_id] == run_generation))
+            pthread_cond_wait(&work_cond, &pool_mutex);
+        if (stopping)
+            break;
+
+        served[pool_id] = run_generation;
+        void *(*worker)(void *) = run_worker;
+        void *arg = run_arg;
+        pthread_mutex_unlock(&pool_mutex);
+
+        wake_us[pool_id] = now_us();
+        worker(arg);
+
+        pthread_mutex_lock(&pool_mutex);
+        if (++run_finished == run_count)
+            pthread_cond_signal(&done_cond);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    perf_counters_thread_exit();
+    return NULL;
+}
+
+// Add workers until there are thread_count; called with pool_mutex held
+static void pool_grow(int thread_count)
+{
+    if (thread_count > pool_capacity)
+    {
+        pool_capacity = thread_count;
+        pool_threads = realloc(pool_threads, pool_capacity * sizeof(pthread_t));
+        served = realloc(served, pool_capacity * sizeof(unsigned long));
+        wake_us = realloc(wake_us, pool_capacity * sizeof(double));
+        begin_us = realloc(begin_us, pool_capacity * sizeof(double));
+        end_us = realloc(end_us, pool_capacity * sizeof(double));
+    }
+
+    for (; pool_size < thread_count; pool_size++)
+    {
+        served[pool_size] = run_generation; // don't pick up a run that is already over
+        if (pthread_create(&pool_threads[pool_size], NULL, pool_thread, (void *)(long)pool_size) != 0)
+        {
+            fprintf(stderr, "Failed to start pool thread %d\n", pool_size);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void thread_pool_start(int thread_count)
+{
+    pthread_mutex_lock(&pool_mutex);
+    pool_grow(thread_count);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+void thread_pool_stop(void)
+{
+    pthread_mutex_lock(&pool_mutex);
+    stopping = 1;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (int i = 0; i < pool_size; i++)
+        pthread_join(pool_threads[i], NULL);
+
+    free(pool_threads);
+    free(served);
+    free(wake_us);
+    free(begin_us);
+    free(end_us);
+    pool_threads = NULL;
+    served = NULL;
+    wake_us = begin_us = end_us = NULL;
+    pool_size = pool_capacity = 0;
+    stopping = 0;
+}
+
+double thread_pool_run(int thread_count, void *(*worker)(void *), void *arg)
+{
+    pthread_mutex_lock(&pool_mutex);
+    pool_grow(thread_count);
+    pthread_barrier_init(&ops_barrier, NULL, thread_count);
+
+    run_worker = worker;
+    run_arg = arg;
+    run_count = thread_count;
+    run_finished = 0;
+    run_generation++;
+    pthread_cond_broadcast(&work_cond);
+
+    while (run_finished < run_count)
+        pthread_cond_wait(&done_cond, &pool_mutex);
+    pthread_mutex_unlock(&pool_mutex);
+    pthread_barrier_destroy(&ops_barrier);
+
+    // The phase starts when the last thread is ready and ends with the last one done
+    double first_wake = wake_us[0], last_wake = wake_us[0];
+    double start = begin_us[0], stop = end_us[0];
+    for (int i = 1; i < thread_count; i++)
+    {
+        if (wake_us[i] < first_wake)
+            first_wake = wake_us[i];
+        if (wake_us[i] > last_wake)
+            last_wake = wake_us[i];
+        if (begin_us[i] > start)
+            start = begin_us[i];
+        if (end_us[i] > stop)
+            stop = end_us[i];
+    }
+    pool_start_skew = last_wake - first_wake;
+
+    return stop > start ? stop - start : 0;
+}
+
+int thread_pool_index(void)
+{
+    return pool_id;
+}
+
+void thread_pool_begin_ops(void)
+{
+    perf_counters_begin();
+    begin_us[pool_id] = now_us();
+    if (pthread_barrier_wait(&ops_barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+        duration_ops_started(); // exactly one worker starts the --duration clock
+}
+
+void thread_pool_end_ops(void)
+{
+    end_us[pool_id] = now_us();
+    perf_counters_end();
+}
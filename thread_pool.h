@@ -0,0 +1,31 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Persistent worker threads shared by every run. main.c starts the pool
+// once and each run_threads hands it a worker function instead of
+// creating and joining its own pthreads. Workers wait at a barrier
+// between their setup and their operation loop, so the time returned by
+// thread_pool_run covers only the operation phase.
+
+// Start thread_count idle workers; the pool grows if a run needs more
+void thread_pool_start(int thread_count);
+void thread_pool_stop(void);
+
+// Run worker(arg) on thread_count pool threads and wait for all of them.
+// Returns the operation phase in microseconds: from the moment the last
+// thread reaches thread_pool_begin_ops to the last thread_pool_end_ops.
+double thread_pool_run(int thread_count, void *(*worker)(void *), void *arg);
+
+// Index of the calling worker within the current run, 0..thread_count-1
+int thread_pool_index(void);
+
+// Called by a worker right before and right after its operation loop;
+// they also start and stop the worker's perf counters (--perf)
+void thread_pool_begin_ops(void);
+void thread_pool_end_ops(void);
+
+// Spread between the first and the last worker picking up the last run,
+// in microseconds; this part of thread startup is kept out of the timing
+extern double pool_start_skew;
+
+#endif
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "linkedlist.h"
+#include "run_threads.h"
+#include "thread_pool.h"
+#include "op_trace.h"
+#include "latency.h"
+#include "duration.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Unrolled list: every node is one cache line holding a sorted block of
+// keys, so a traversal touches one line per UNROLLED_KEYS keys instead of
+// one per key. The list is protected by a single read-write lock, exactly
+// like rw_lock.c, so the difference measured is the layout.
+
+#define CACHE_LINE 64
+#define UNROLLED_KEYS 14 // 14 ints + next pointer = 64 bytes
+#define UNROLLED_FILL 12 // keys per node when building, leaves room for inserts
+#define UNROLLED_MERGE (UNROLLED_KEYS / 2) // merge with the next node below this
+#define EMPTY_KEY INT_MAX // unused slots; never a valid key
+
+struct unrolled_node_s
+{
+    int keys[UNROLLED_KEYS]; // sorted, unused slots at the end hold EMPTY_KEY
+    struct unrolled_node_s *next;
+};
+
+typedef struct
+{
+    struct unrolled_node_s **head;
+    int m;
+    double mMember, mInsert, mDelete;
+    int thread_count;
+    pthread_rwlock_t *rwlock;
+} thread_params_t;
+
+static struct unrolled_node_s *unrolled_new_node(void)
+{
+    // Round up so aligned_alloc gets a multiple of the alignment
+    size_t size = (sizeof(struct unrolled_node_s) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    struct unrolled_node_s *node = aligned_alloc(CACHE_LINE, size);
+    for (int i = 0; i < UNROLLED_KEYS; i++)
+        node->keys[i] = EMPTY_KEY;
+    node->next = NULL;
+    return node;
+}
+
+static int unrolled_count(const struct unrolled_node_s *node)
+{
+    int count = 0;
+    while (count < UNROLLED_KEYS && node->keys[count] != EMPTY_KEY)
+        count++;
+    return count;
+}
+
+// Is value in this block? Compares every slot at once; empty slots never match.
+static int block_contains(const int *keys, int value)
+{
+#if defined(__AVX2__)
+    __m256i v = _mm256_set1_epi32(value);
+    __m256i lo = _mm256_loadu_si256((const __m256i *)keys);       // keys[0..7]
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(keys + 6)); // keys[6..13]
+    __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi32(lo, v), _mm256_cmpeq_epi32(hi, v));
+    return !_mm256_testz_si256(eq, eq);
+#elif defined(__SSE2__)
+    __m128i v = _mm_set1_epi32(value);
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)keys), v);
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(keys + 4)), v));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(keys + 8)), v));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(keys + 10)), v));
+    return _mm_movemask_epi8(eq) != 0;
+#else
+    for (int i = 0; i < UNROLLED_KEYS; i++)
+        if (keys[i] == value)
+            return 1;
+    return 0;
+#endif
+}
+
+// Find the node that would hold value: the last node whose first key is
+// <= value, or the first node if value is smaller than every key
+static struct unrolled_node_s *unrolled_locate(int value, struct unrolled_node_s *head_p,
+                                               struct unrolled_node_s **pred_pp)
+{
+    struct unrolled_node_s *pred_p = NULL;
+    struct unrolled_node_s *curr_p = head_p;
+    while (curr_p->next != NULL && curr_p->next->keys[0] <= value)
+    {
+        pred_p = curr_p;
+        curr_p = curr_p->next;
+    }
+    if (pred_pp != NULL)
+        *pred_pp = pred_p;
+    return curr_p;
+}
+
+static int unrolled_member(int value, struct unrolled_node_s *head_p)
+{
+    if (head_p == NULL)
+        return 0;
+    return block_contains(unrolled_locate(value, head_p, NULL)->keys, value);
+}
+
+static int unrolled_insert(int value, struct unrolled_node_s **head_pp)
+{
+    if (*head_pp == NULL)
+    {
+        *head_pp = unrolled_new_node();
+        (*head_pp)->keys[0] = value;
+        return 1;
+    }
+
+    struct unrolled_node_s *curr_p = unrolled_locate(value, *head_pp, NULL);
+    if (block_contains(curr_p->keys, value))
+        return 0;
+
+    int count = unrolled_count(curr_p);
+    if (count == UNROLLED_KEYS)
+    {
+        // Split: move the upper half into a new node after curr
+        struct unrolled_node_s *temp_p = unrolled_new_node();
+        int half = UNROLLED_KEYS / 2;
+        for (int i = half; i < UNROLLED_KEYS; i++)
+        {
+            temp_p->keys[i - half] = curr_p->keys[i];
+            curr_p->keys[i] = EMPTY_KEY;
+        }
+        temp_p->next = curr_p->next;
+        curr_p->next = temp_p;
+        count = half;
+
+        if (value > temp_p->keys[0])
+            curr_p = temp_p;
+    }
+
+    // Shift larger keys up one slot and drop value in
+    int pos = count;
+    while (pos > 0 && curr_p->keys[pos - 1] > value)
+    {
+        curr_p->keys[pos] = curr_p->keys[pos - 1];
+        pos--;
+    }
+    curr_p->keys[pos] = value;
+    return 1;
+}
+
+static int unrolled_delete(int value, struct unrolled_node_s **head_pp)
+{
+    if (*head_pp == NULL)
+        return 0;
+
+    struct unrolled_node_s *pred_p;
+    struct unrolled_node_s *curr_p = unrolled_locate(value, *head_pp, &pred_p);
+    if (!block_contains(curr_p->keys, value))
+        return 0;
+
+    int count = unrolled_count(curr_p);
+    int pos = 0;
+    while (curr_p->keys[pos] != value)
+        pos++;
+    for (int i = pos; i < count - 1; i++)
+        curr_p->keys[i] = curr_p->keys[i + 1];
+    curr_p->keys[count - 1] = EMPTY_KEY;
+    count--;
+
+    if (count == 0)
+    {
+        // Unlink the empty node
+        if (pred_p == NULL)
+            *head_pp = curr_p->next;
+        else
+            pred_p->next = curr_p->next;
+        free(curr_p);
+    }
+    else if (count < UNROLLED_MERGE && curr_p->next != NULL)
+    {
+        // Merge the next node in if both fit in one line
+        struct unrolled_node_s *next_p = curr_p->next;
+        int next_count = unrolled_count(next_p);
+        if (count + next_count <= UNROLLED_KEYS)
+        {
+            for (int i = 0; i < next_count; i++)
+                curr_p->keys[count + i] = next_p->keys[i];
+            curr_p->next = next_p->next;
+            free(next_p);
+        }
+    }
+    return 1;
+}
+
+// Pack the (already sorted) initial list into blocks of UNROLLED_FILL keys
+static struct unrolled_node_s *unrolled_build(struct list_node_s *head_p, int *node_count)
+{
+    struct unrolled_node_s *head = NULL;
+    struct unrolled_node_s *tail = NULL;
+    int fill = UNROLLED_FILL;
+    *node_count = 0;
+
+    for (struct list_node_s *curr_p = head_p; curr_p != NULL; curr_p = curr_p->next)
+    {
+        if (fill == UNROLLED_FILL)
+        {
+            struct unrolled_node_s *node = unrolled_new_node();
+            if (tail == NULL)
+                head = node;
+            else
+                tail->next = node;
+            tail = node;
+            fill = 0;
+            (*node_count)++;
+        }
+        tail->keys[fill++] = curr_p->data;
+    }
+    return head;
+}
+
+static void unrolled_destroy(struct unrolled_node_s *head)
+{
+    struct unrolled_node_s *curr_p = head;
+    while (curr_p != NULL)
+    {
+        struct unrolled_node_s *next = curr_p->next;
+        free(curr_p);
+        curr_p = next;
+    }
+}
+
+static void *thread_worker(void *args)
+{
+    thread_params_t *params = (thread_params_t *)args;
+
+    // This thread's operations, generated now or read from the trace
+    op_stream_t stream;
+    op_stream_open(&stream, thread_pool_index(), params->m, params->mMember,
+                   params->mInsert, params->mDelete, params->thread_count);
+    const uint32_t *ops = stream.ops;
+    int totalOps = stream.count;
+
+    // Wait until every thread has finished its setup
+    thread_pool_begin_ops();
+
+    // Step 3: Execute operations with correct locks
+    for (int i = 0; duration_more_ops(&i, totalOps, 1); i++)
+    {
+        int op = TRACE_OP(ops[i]);
+        int val = TRACE_KEY(ops[i]);
+        uint64_t op_start = latency_start();
+
+        if (op == 0)
+        {
+            pthread_rwlock_wrlock(params->rwlock);
+            unrolled_insert(val, params->head);
+            pthread_rwlock_unlock(params->rwlock);
+        }
+        else if (op == 1)
+        {
+            pthread_rwlock_wrlock(params->rwlock);
+            unrolled_delete(val, params->head);
+            pthread_rwlock_unlock(params->rwlock);
+        }
+        else
+        {
+            pthread_rwlock_rdlock(params->rwlock);
+            unrolled_member(val, *(params->head));
+            pthread_rwlock_unlock(params->rwlock);
+        }
+
+        latency_record(op, op_start);
+    }
+    thread_pool_end_ops();
+
+    op_stream_close(&stream);
+    return NULL;
+}
+
+double run_threads_unrolled(struct list_node_s **list_head,
+                            int m,
+                            double mMember,
+                            double mInsert,
+                            double mDelete,
+                            int thread_count,
+                            int program_type)
+{
+    if (program_type != 7) // 7 = unrolled list version
+    {
+        fprintf(stderr, "Only unrolled list version (program_type=7) is implemented in this function.\n");
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL)); // random seed
+
+    pthread_rwlock_t rwlock;
+    pthread_rwlock_init(&rwlock, NULL);
+
+    // Convert the initial list outside the timed region
+    int key_count = 0;
+    for (struct list_node_s *curr_p = *list_head; curr_p != NULL; curr_p = curr_p->next)
+        key_count++;
+    int node_count;
+    struct unrolled_node_s *head = unrolled_build(*list_head, &node_count);
+
+    thread_params_t params = {&head, m, mMember, mInsert, mDelete,
+                              thread_count, &rwlock};
+
+    // Footprint of the payload: one line per block vs one node per key
+    printf("Unrolled list: %d keys in %d blocks, %zu bytes (%.1f bytes/key) vs linked list %zu bytes (%zu bytes/key)\n",
+           key_count, node_count, node_count * (size_t)CACHE_LINE,
+           key_count ? (double)node_count * CACHE_LINE / key_count : 0.0,
+           key_count * sizeof(struct list_node_s), sizeof(struct list_node_s));
+    printf("Running in unrolled list mode with %d threads and %d operations\n", thread_count, m);
+
+    // Run on the persistent pool; only the operation phase is timed
+    unsigned long elapsed_time = (unsigned long)thread_pool_run(thread_count, thread_worker, &params);
+
+    // Free both lists
+    unrolled_destroy(head);
+    destructor(*list_head); // free all nodes
+    *list_head = NULL;
+    pthread_rwlock_destroy(&rwlock);
+
+    return elapsed_time;
+}